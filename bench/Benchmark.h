@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Allocations class
+ *
+ * Heap allocations counted by the global operator new of the benchmark.
+ */
+class Allocations
+{
+public:
+    inline static std::atomic<size_t> count{0U}; //!< Number of allocations
+    inline static std::atomic<size_t> bytes{0U}; //!< Allocated bytes
+};
+
+/**
+ * Result class
+ */
+class Result
+{
+public:
+    std::string name{}; //!< Benchmark name
+    size_t size{0U}; //!< Problem size
+    size_t iterations{0U}; //!< Measured steps
+    double nsPerStep{0.}; //!< Time per step
+    double evaluationsPerSecond{0.}; //!< Derivative evaluations per second
+    double bytesPerStep{0.}; //!< Allocated bytes per step
+    double allocationsPerStep{0.}; //!< Allocations per step
+};
+
+/**
+ * Keep a value from being optimized away, the empty assembly reads the value without a store
+ */
+template<typename T>
+void keep(const T& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+/**
+ * Benchmark class
+ */
+class Benchmark
+{
+public:
+    /**
+     * Create benchmark
+     * @param filter     Run benchmarks whose name contains the filter only
+     * @param minTime    Minimum measured time in seconds per benchmark
+     * @param maxBodies  Maximum number of bodies of the particle benchmarks
+     */
+    Benchmark(const std::string& filter, const double minTime, const size_t maxBodies)
+        : m_filter{filter}
+        , m_minTime{minTime}
+        , m_maxBodies{maxBodies}
+    {
+    }
+
+    [[nodiscard]] size_t maxBodies() const
+    {
+        return m_maxBodies;
+    }
+
+    /**
+     * Return whether a benchmark is selected by the filter
+     */
+    [[nodiscard]] bool selected(const std::string& name) const
+    {
+        return name.find(m_filter) != std::string::npos;
+    }
+
+    /**
+     * Return whether any of the benchmarks is selected by the filter, expensive setups are skipped otherwise
+     */
+    [[nodiscard]] bool selected(std::initializer_list<const char*> names) const
+    {
+        return std::any_of(names.begin(), names.end(), [this](const char* name) { return selected(std::string{name}); });
+    }
+
+    /**
+     * Measure a step
+     * @param name         Benchmark name
+     * @param size         Problem size
+     * @param evaluations  Derivative evaluations per step
+     * @param step         Function running a single step
+     */
+    template<typename F>
+    void run(const std::string& name, const size_t size, const double evaluations, F&& step)
+    {
+        if (!selected(name))
+        {
+            return;
+        }
+
+        // Warm up, buffers are allocated by the first step
+        step();
+
+        using Clock = std::chrono::steady_clock;
+        size_t iterations{1U};
+        while (true)
+        {
+            const size_t count{Allocations::count.load()};
+            const size_t bytes{Allocations::bytes.load()};
+            const auto start = Clock::now();
+            for (size_t i{0U}; i < iterations; ++i)
+            {
+                step();
+            }
+            const double elapsed{std::chrono::duration<double>(Clock::now() - start).count()};
+            const size_t allocations{Allocations::count.load() - count};
+            const size_t allocated{Allocations::bytes.load() - bytes};
+            if (elapsed >= m_minTime || iterations >= (size_t{1U} << 30U))
+            {
+                Result result{};
+                result.name = name;
+                result.size = size;
+                result.iterations = iterations;
+                result.nsPerStep = elapsed * 1e9 / static_cast<double>(iterations);
+                result.evaluationsPerSecond = evaluations * static_cast<double>(iterations) / elapsed;
+                result.bytesPerStep = static_cast<double>(allocated) / static_cast<double>(iterations);
+                result.allocationsPerStep = static_cast<double>(allocations) / static_cast<double>(iterations);
+                m_results.push_back(result);
+                return;
+            }
+            // Aim at the minimum time with the next attempt
+            const double scale{elapsed > 0. ? 1.5 * m_minTime / elapsed : 10.};
+            iterations = std::max(iterations + 1U, static_cast<size_t>(static_cast<double>(iterations) * std::min(scale, 10.)));
+        }
+    }
+
+    /**
+     * Print results as table
+     */
+    void print(std::ostream& stream) const
+    {
+        stream << std::left << std::setw(40) << "name" << std::right << std::setw(10) << "size" << std::setw(16) << "ns/step" << std::setw(16) << "evals/s" << std::setw(14) << "bytes/step" << std::endl;
+        for (const auto& result : m_results)
+        {
+            stream << std::left << std::setw(40) << result.name << std::right << std::setw(10) << result.size << std::setw(16) << std::setprecision(6) << result.nsPerStep << std::setw(16) << result.evaluationsPerSecond << std::setw(14) << result.bytesPerStep << std::endl;
+        }
+    }
+
+    /**
+     * Print results as JSON
+     */
+    void json(std::ostream& stream, const std::string& isa) const
+    {
+        stream << "{\n  \"isa\": \"" << isa << "\",\n  \"benchmarks\": [";
+        for (size_t i{0U}; i < m_results.size(); ++i)
+        {
+            const auto& result = m_results[i];
+            stream << (i > 0U ? "," : "") << "\n    {\"name\": \"" << result.name << "\", \"size\": " << result.size << ", \"iterations\": " << result.iterations;
+            stream << std::setprecision(9) << ", \"ns_per_step\": " << result.nsPerStep << ", \"evaluations_per_second\": " << result.evaluationsPerSecond;
+            stream << ", \"bytes_per_step\": " << result.bytesPerStep << ", \"allocations_per_step\": " << result.allocationsPerStep << "}";
+        }
+        stream << "\n  ]\n}" << std::endl;
+    }
+
+private:
+    std::string m_filter{};
+    double m_minTime{0.};
+    size_t m_maxBodies{0U};
+    std::vector<Result> m_results{};
+};
+
+void benchmarkOde(Benchmark& benchmark);
+void benchmarkMolecularDynamics(Benchmark& benchmark);
+void benchmarkPlanetDynamics(Benchmark& benchmark);
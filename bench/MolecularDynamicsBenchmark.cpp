@@ -0,0 +1,58 @@
+#include "Benchmark.h"
+#include "moleculardynamics/World.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Bodies on a cubic lattice with a spacing near the potential minimum
+std::vector<md::Body> lattice(const size_t count)
+{
+    static constexpr float_t SPACING{45.F};
+    const size_t side{static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(count))))};
+    std::vector<md::Body> bodies(count);
+    for (size_t i{0U}; i < count; ++i)
+    {
+        bodies[i].position[0] = SPACING * static_cast<float_t>(i % side);
+        bodies[i].position[1] = SPACING * static_cast<float_t>((i / side) % side);
+        bodies[i].position[2] = SPACING * static_cast<float_t>(i / (side * side));
+        bodies[i].mass = 1.F;
+    }
+    return bodies;
+}
+}
+
+void benchmarkMolecularDynamics(Benchmark& benchmark)
+{
+    for (size_t count{10U}; count <= benchmark.maxBodies(); count *= 10U)
+    {
+        if (!benchmark.selected({"MolecularDynamics::lennardJones", "MolecularDynamics::lennardJones(1 thread)", "MolecularDynamics::lennardJones(scalar)", "MolecularDynamics::lennardJones(periodic)", "MolecularDynamics::VelocityVerlet"}))
+        {
+            return;
+        }
+        md::World world{};
+        world.initialize(lattice(count));
+        benchmark.run("MolecularDynamics::lennardJones", count, 1., [&]() { world.lennardJones(); });
+        if (world.threads() > 1U)
+        {
+            world.setThreads(1U);
+            benchmark.run("MolecularDynamics::lennardJones(1 thread)", count, 1., [&]() { world.lennardJones(); });
+            world.setThreads(0U);
+        }
+        world.setVectorized(false);
+        benchmark.run("MolecularDynamics::lennardJones(scalar)", count, 1., [&]() { world.lennardJones(); });
+        world.setVectorized(true);
+
+        // Periodic box of the lattice decomposed into slabs
+        const float_t side{45.F * std::ceil(std::cbrt(static_cast<float_t>(count)))};
+        const float_t box[3]{side, side, side};
+        if (world.setBox(box))
+        {
+            benchmark.run("MolecularDynamics::lennardJones(periodic)", count, 1., [&]() { world.lennardJones(); });
+            const float_t open[3]{};
+            world.setBox(open);
+        }
+
+        benchmark.run("MolecularDynamics::VelocityVerlet", count, 1., [&]() { world.integrate(0.F, 0.0001F); });
+    }
+}
@@ -0,0 +1,133 @@
+#include "Benchmark.h"
+#include "ode/DormandPrince.h"
+#include "ode/Euler.h"
+#include "ode/MidPoint.h"
+#include "ode/RungeKutta.h"
+#include "ode/VelocityVerlet.h"
+#include <cmath>
+#include <string>
+
+namespace
+{
+using Vector = ode::Vector<float_t>;
+using Function = ode::Function<float_t>;
+using Solver = ode::Solver<float_t>;
+using Workspace = ode::Workspace<float_t>;
+
+// Exponential decay y' = -y
+class Decay : public Function
+{
+public:
+    explicit Decay(const size_t size)
+        : m_data(size)
+    {
+        for (size_t i{0U}; i < size; ++i)
+        {
+            m_data[i] = 1.F + static_cast<float_t>(i % 13U);
+        }
+    }
+
+    Vector derive(float_t x, Vector& y) final
+    {
+        Vector dydx(y.size());
+        derive(x, y, dydx);
+        return dydx;
+    }
+
+    void derive([[maybe_unused]] float_t x, Vector& y, Vector& dydx) final
+    {
+        dydx = -y;
+    }
+
+    Vector derive2(float_t x, Vector& y, Vector& dy) final
+    {
+        Vector dyd2x(y.size());
+        derive2(x, y, dy, dyd2x);
+        return dyd2x;
+    }
+
+    void derive2(float_t x, Vector& y, Vector& dy, Vector& dyd2x) final
+    {
+        dyd2x = y + dy * x;
+    }
+
+    Vector getParams() const final
+    {
+        return m_data;
+    }
+
+    void getParams(Vector& y) const final
+    {
+        y = m_data;
+    }
+
+    void setParams(const Vector& y) final
+    {
+        // Compensate the decay of dt = 0.001, denormal values would distort the timing
+        m_data += y;
+        m_data *= 1.001F;
+    }
+
+private:
+    Vector m_data;
+};
+
+void benchmarkSolver(Benchmark& benchmark, const std::string& name, Solver& solver, const double evaluations)
+{
+    static constexpr float_t dt{0.001F};
+    for (size_t size : {size_t{3U}, size_t{100U}, size_t{10'000U}, size_t{1'000'000U}})
+    {
+        Decay decay(size);
+        Workspace workspace{};
+        float_t t{0.F};
+        benchmark.run(name, size, evaluations, [&]() {
+            solver.calc(t, dt, decay, workspace);
+            t += dt;
+        });
+    }
+}
+
+void benchmarkVector(Benchmark& benchmark)
+{
+    for (size_t size : {size_t{3U}, size_t{1'000U}, size_t{1'000'000U}})
+    {
+        Vector a(size);
+        Vector b(size);
+        Vector y(size);
+        for (size_t i{0U}; i < size; ++i)
+        {
+            a[i] = static_cast<float_t>(i % 7U);
+            b[i] = 1.F / static_cast<float_t>(i + 1U);
+        }
+        benchmark.run("Vector y = a + b * s", size, 0., [&]() { y = a + b * 0.5F; });
+        benchmark.run("Vector y += a", size, 0., [&]() { y += a; });
+        benchmark.run("Vector y.axpy(s, a)", size, 0., [&]() { y.axpy(1e-3F, a); });
+        benchmark.run("Vector dot", size, 0., [&]() { keep(a.dot(b)); });
+        benchmark.run("Vector norm(2)", size, 0., [&]() { keep(a.norm(2U)); });
+        benchmark.run("Vector normInf", size, 0., [&]() { keep(a.normInf()); });
+    }
+}
+}
+
+void benchmarkOde(Benchmark& benchmark)
+{
+    ode::Euler<float_t> euler{};
+    ode::MidPoint<float_t> midPoint{};
+    ode::RungeKutta<float_t> rungeKutta{};
+    ode::DormandPrince<float_t> dormandPrince{};
+    ode::VelocityVerlet<float_t> velocityVerlet{};
+    benchmarkSolver(benchmark, "Euler::calc", euler, 1.);
+    benchmarkSolver(benchmark, "MidPoint::calc", midPoint, 2.);
+    benchmarkSolver(benchmark, "RungeKutta::calc", rungeKutta, 4.);
+    benchmarkSolver(benchmark, "DormandPrince::calc", dormandPrince, 7.);
+    benchmarkSolver(benchmark, "VelocityVerlet::calc", velocityVerlet, 2.);
+
+    // Returning interface, allocates per step
+    for (size_t size : {size_t{3U}, size_t{10'000U}})
+    {
+        Decay decay(size);
+        benchmark.run("RungeKutta::calc (returning)", size, 4., [&]() { keep(rungeKutta.calc(0.F, 0.001F, decay).size()); });
+    }
+
+    benchmarkVector(benchmark);
+}
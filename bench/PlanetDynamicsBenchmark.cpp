@@ -0,0 +1,45 @@
+#include "Benchmark.h"
+#include "planetdynamics/World.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Bodies on a spiral around a central mass
+std::vector<pd::Body> disk(const size_t count)
+{
+    std::vector<pd::Body> bodies(count);
+    bodies[0].mass = 1e7F;
+    for (size_t i{1U}; i < count; ++i)
+    {
+        const float_t angle{0.1F * static_cast<float_t>(i)};
+        const float_t radius{50.F + static_cast<float_t>(i)};
+        bodies[i].position[0] = radius * std::cos(angle);
+        bodies[i].position[1] = radius * std::sin(angle);
+        bodies[i].velocity[0] = -std::sin(angle) * std::sqrt(1e7F / radius);
+        bodies[i].velocity[1] = std::cos(angle) * std::sqrt(1e7F / radius);
+        bodies[i].mass = 1.F;
+    }
+    return bodies;
+}
+}
+
+void benchmarkPlanetDynamics(Benchmark& benchmark)
+{
+    for (size_t count{10U}; count <= benchmark.maxBodies(); count *= 10U)
+    {
+        if (!benchmark.selected({"PlanetDynamics::derive", "PlanetDynamics::derive(octree)"}))
+        {
+            return;
+        }
+        pd::World world{};
+        world.initialize(disk(count));
+        pd::Function& function{world};
+        pd::Vector y{function.getParams()};
+        pd::Vector dydx(y.size());
+        benchmark.run("PlanetDynamics::derive", count, 1., [&]() { function.derive(0.F, y, dydx); });
+        world.setTheta(0.5F);
+        benchmark.run("PlanetDynamics::derive(octree)", count, 1., [&]() { function.derive(0.F, y, dydx); });
+        world.setTheta(0.F);
+    }
+}
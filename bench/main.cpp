@@ -0,0 +1,82 @@
+#include "Benchmark.h"
+#include "ode/Simd.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+void* operator new(size_t size)
+{
+    Allocations::count++;
+    Allocations::bytes += size;
+    // operator new(0) must return a unique pointer, malloc(0) may return null
+    if (void* ptr = std::malloc(size > 0U ? size : 1U))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, [[maybe_unused]] size_t size) noexcept
+{
+    std::free(ptr);
+}
+
+/**
+ * main function
+ */
+int main(int argc, char** argv)
+{
+    std::string filter{};
+    std::string json{};
+    double minTime{0.2};
+    size_t maxBodies{100'000U};
+    for (int i{1}; i + 1 < argc; i += 2)
+    {
+        const std::string option{argv[i]};
+        if (option == "--filter")
+        {
+            filter = argv[i + 1];
+        }
+        else if (option == "--json")
+        {
+            json = argv[i + 1];
+        }
+        else if (option == "--min-time")
+        {
+            minTime = std::stod(argv[i + 1]);
+        }
+        else if (option == "--max-bodies")
+        {
+            maxBodies = std::stoul(argv[i + 1]);
+        }
+        else
+        {
+            std::cout << "Usage: benchmark [--filter name] [--json file] [--min-time seconds] [--max-bodies count]" << std::endl;
+            return -1;
+        }
+    }
+
+    static const char* ISA[]{"scalar", "sse2", "avx2", "avx512"};
+    const std::string isa{ISA[static_cast<size_t>(ode::simd::kernels<float_t>().isa)]};
+    std::cout << "Kernels = " << isa << std::endl;
+
+    Benchmark benchmark(filter, minTime, maxBodies);
+    benchmarkOde(benchmark);
+    benchmarkMolecularDynamics(benchmark);
+    benchmarkPlanetDynamics(benchmark);
+
+    benchmark.print(std::cout);
+    if (!json.empty())
+    {
+        std::ofstream file(json, std::ios::out | std::ios::trunc);
+        benchmark.json(file, isa);
+    }
+    return 0;
+}
@@ -1,10 +1,16 @@
+#include "ode/EnsembleRungeKutta.h"
 #include "ode/RungeKutta.h"
 #include <cmath>
 #include <iostream>
+#include <string>
 
-using Vector = ode::Vector<float_t>;
-using Function = ode::Function<float_t>;
-using RungeKutta = ode::RungeKutta<float_t>;
+using Vector = ode::Vector<float_t, 3>;
+using Function = ode::Function<float_t, 3>;
+using RungeKutta = ode::RungeKutta<float_t, 3>;
+using Workspace = ode::Workspace<float_t, 3>;
+using Ensemble = ode::Ensemble<float_t>;
+using EnsembleFunction = ode::EnsembleFunction<float_t>;
+using EnsembleRungeKutta = ode::EnsembleRungeKutta<float_t>;
 
 // Lorenz ODE
 class Lorenz : public Function
@@ -17,22 +23,32 @@ public:
     }
 
     Vector derive(float_t x, Vector& y) final
+    {
+        Vector dydx{};
+        derive(x, y, dydx);
+        return dydx;
+    }
+
+    void derive([[maybe_unused]] float_t x, Vector& y, Vector& dydx) final
     {
         static constexpr float_t a = 10.F;
         static constexpr float_t b = 28.F;
         static constexpr float_t c = 8.F / 3.F;
 
-        Vector dydx(3u);
-        dydx[0u] = a * (y[1u] - y[0u]);
-        dydx[1u] = b * y[0u] - y[1u] - y[0u] * y[2u];
-        dydx[2u] = y[0u] * y[1u] - c * y[2u];
-        return dydx * m_dt;
+        dydx[0u] = a * (y[1u] - y[0u]) * m_dt;
+        dydx[1u] = (b * y[0u] - y[1u] - y[0u] * y[2u]) * m_dt;
+        dydx[2u] = (y[0u] * y[1u] - c * y[2u]) * m_dt;
     }
     
     Vector getParams() const final
     {
         return m_data;
     }
+
+    void getParams(Vector& y) const final
+    {
+        y = m_data;
+    }
     
     void setParams(const Vector& y) final
     {
@@ -44,18 +60,89 @@ private:
     float_t m_dt;
 };
 
+// Lorenz ODE of many instances with individual parameters
+class LorenzEnsemble : public EnsembleFunction
+{
+public:
+    LorenzEnsemble(const size_t count, const float_t dt)
+        : m_a(count, 10.F)
+        , m_b(count, 28.F)
+        , m_c(count, 8.F / 3.F)
+        , m_dt{dt}
+    {
+        // Spread parameter b over the instances
+        for (size_t i{0U}; i < count; ++i)
+        {
+            m_b[i] += static_cast<float_t>(i) / static_cast<float_t>(count);
+        }
+    }
+
+    void derive([[maybe_unused]] float_t x, const Ensemble& y, Ensemble& dydx) final
+    {
+        const float_t* y0{y.component(0u)};
+        const float_t* y1{y.component(1u)};
+        const float_t* y2{y.component(2u)};
+        float_t* dy0{dydx.component(0u)};
+        float_t* dy1{dydx.component(1u)};
+        float_t* dy2{dydx.component(2u)};
+        const float_t* a{m_a.data()};
+        const float_t* b{m_b.data()};
+        const float_t* c{m_c.data()};
+
+        const size_t count{y.count()};
+        for (size_t i{0U}; i < count; ++i)
+        {
+            dy0[i] = a[i] * (y1[i] - y0[i]) * m_dt;
+            dy1[i] = (b[i] * y0[i] - y1[i] - y0[i] * y2[i]) * m_dt;
+            dy2[i] = (y0[i] * y1[i] - c[i] * y2[i]) * m_dt;
+        }
+    }
+
+private:
+    std::vector<float_t> m_a;
+    std::vector<float_t> m_b;
+    std::vector<float_t> m_c;
+    float_t m_dt;
+};
+
 // Main function
 int main(int argc, char** argv)
 {
     static constexpr float_t dt{0.05F};
 
+    // Integrate many instances and print their final state
+    if (argc > 2 && std::string("--ensemble") == argv[1])
+    {
+        const size_t count{std::stoul(argv[2])};
+        EnsembleRungeKutta rk{};
+        LorenzEnsemble function(count, dt);
+        Ensemble y(3u, count);
+        for (size_t i{0U}; i < count; ++i)
+        {
+            y(0u, i) = 1.F;
+        }
+
+        for (float_t t{0.0F}; t < 2'000.F; t += dt)
+        {
+            rk.calc(t, dt, function, y);
+        }
+        for (size_t i{0U}; i < count; ++i)
+        {
+            std::cout << y(0u, i) << "," << y(2u, i) << std::endl;
+        }
+        return 0;
+    }
+
     RungeKutta rk{};
+    Workspace workspace{};
+    Vector state{};
     Lorenz y(dt);
 
     for (float_t t{0.0F}; t < 2'000.F; t += dt)
     {
-        rk.calc(t, dt, y);
-        std::cout << y.getParams()[0u]<< "," << y.getParams()[2u] << std::endl;
+        rk.step(t, dt, y, workspace);
+        y.getParams(state);
+        std::cout << state[0u] << "," << state[2u] << std::endl;
     }
 
     return 0;
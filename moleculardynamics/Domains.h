@@ -0,0 +1,384 @@
+#pragma once
+
+#include "LennardJones.h"
+#include "NeighborList.h"
+#include "Particles.h"
+#include "ode/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace md
+{
+/**
+ * Domains class
+ *
+ * Spatial domain decomposition of a periodic box into slabs along its
+ * longest axis, one slab per thread. Each domain owns the particles of its
+ * slab and keeps halo copies of the particles of the next slab, which are
+ * within the cutoff radius plus skin of the boundary. Every step a domain
+ * gathers the positions of its particles and halos into local arrays and
+ * calculates their forces with its own neighbor list. Afterwards the forces
+ * on the halos are returned to the owning domain. Each pair is calculated
+ * once, the threads never write to the particles of another domain. The
+ * slabs are rebuilt together with the neighbor lists, after a particle moved
+ * more than half the skin, and the positions are wrapped into the box then.
+ */
+class Domains
+{
+public:
+    Domains() = default;
+
+    /**
+     * Set periodic box
+     * @param box        Box lengths of the three axes, zero for an open system
+     * @param cutoff     Cutoff radius
+     * @param skin       Skin distance of the neighbor lists
+     * @return false if a box length is less than twice the cutoff radius plus skin, nothing is changed then
+     */
+    bool setBox(const float_t* box, const float_t cutoff, const float_t skin)
+    {
+        const float_t radius{cutoff + skin};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            if (box[k] != 0.F && box[k] < 2.F * radius)
+            {
+                return false;
+            }
+        }
+        m_radius = radius;
+        m_cutoff = cutoff;
+        m_skin = skin;
+        std::copy(box, box + 3U, m_box);
+        m_axis = static_cast<size_t>(std::max_element(m_box, m_box + 3U) - m_box);
+        m_valid = false;
+        return true;
+    }
+
+    /**
+     * Return true if all axes are periodic
+     */
+    [[nodiscard]] bool periodic() const
+    {
+        return m_box[0] > 0.F && m_box[1] > 0.F && m_box[2] > 0.F;
+    }
+
+    /**
+     * Number of domains
+     */
+    [[nodiscard]] size_t size() const
+    {
+        return m_domains.size();
+    }
+
+    /**
+     * Number of partitions
+     */
+    [[nodiscard]] size_t builds() const
+    {
+        return m_builds;
+    }
+
+    /**
+     * Calculate the forces of the particles, which replace the previous ones
+     * @param particles  Particles, their positions are wrapped into the box when the domains are rebuilt
+     * @param parameters Potential parameters with the box
+     * @param kernel     Periodic pair kernel
+     * @param pool       Threads, each calculates the domains thread, thread + pool.size(), ...
+     * @return Potential energy and virial
+     */
+    lj::Sums forces(Particles& particles, const lj::Parameters& parameters, const lj::Kernel kernel, ode::ThreadPool& pool)
+    {
+        if (outdated(particles, pool))
+        {
+            rebuild(particles, pool);
+        }
+        const size_t threads{pool.size()};
+
+        // Exchange the halo positions and calculate the forces of each domain
+        lj::Parameters local{parameters};
+        local.box[m_axis] = 0.F;
+        pool.run([&](size_t thread) {
+            for (size_t d{thread}; d < m_domains.size(); d += threads)
+            {
+                calculate(d, particles, local, kernel);
+            }
+        });
+
+        // Return the halo forces to their owners
+        pool.run([&](size_t thread) {
+            for (size_t d{thread}; d < m_domains.size(); d += threads)
+            {
+                collect(d, particles);
+            }
+        });
+
+        lj::Sums sums{};
+        for (const auto& domain : m_domains)
+        {
+            sums += domain.sums;
+        }
+        return sums;
+    }
+
+    /**
+     * Save the positions of the last partition, see ode/Checkpoint.h
+     */
+    template<typename A>
+    void write(A& archive) const
+    {
+        archive.write(static_cast<uint64_t>(m_valid ? m_domains.size() : 0U));
+        archive.write(static_cast<uint64_t>(m_builds));
+        archive.write(m_reference);
+    }
+
+    /**
+     * Restore the partition from the saved positions, so it equals the saved one
+     */
+    template<typename A>
+    bool read(A& archive)
+    {
+        uint64_t domains{0U};
+        uint64_t builds{0U};
+        if (!archive.read(domains) || !archive.read(builds) || !archive.read(m_reference) || m_reference.size() % 3U != 0U)
+        {
+            return false;
+        }
+        m_valid = false;
+        if (domains > 0U)
+        {
+            m_domains.resize(domains);
+            for (size_t d{0U}; d < domains; ++d)
+            {
+                partition(d);
+            }
+            m_valid = true;
+        }
+        m_builds = builds;
+        return true;
+    }
+
+private:
+    struct Domain
+    {
+        std::vector<size_t> index{}; //!< Particle of each local particle, owned particles first
+        size_t owned{0U}; //!< Number of owned particles
+        std::vector<float_t> position{}; //!< Local positions per axis
+        std::vector<float_t> force{}; //!< Local forces per axis
+        NeighborList neighbors{};
+        lj::Sums sums{};
+    };
+
+    /**
+     * Return true if a particle moved more than half the skin since the last partition
+     */
+    bool outdated(const Particles& particles, ode::ThreadPool& pool) const
+    {
+        const size_t count{particles.size()};
+        if (!m_valid || m_reference.size() != count * 3U || m_domains.size() != domains(pool.size()))
+        {
+            return true;
+        }
+        const float_t limit{.25F * m_skin * m_skin};
+        std::atomic<bool> moved{false};
+        pool.parallelFor(count, GRAIN, [&](size_t, size_t begin, size_t end) {
+            for (size_t i{begin}; i < end && !moved.load(std::memory_order_relaxed); ++i)
+            {
+                float_t r2{0.F};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    const float_t d{particles.position(k)[i] - m_reference[k * count + i]};
+                    r2 += d * d;
+                }
+                if (r2 > limit)
+                {
+                    moved.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+        return moved.load();
+    }
+
+    /**
+     * Wrap the positions into the box and partition them
+     */
+    void rebuild(Particles& particles, ode::ThreadPool& pool)
+    {
+        const size_t count{particles.size()};
+        m_reference.resize(count * 3U);
+        pool.parallelFor(count, GRAIN, [&](size_t, size_t begin, size_t end) {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                float_t* position{particles.position(k)};
+                for (size_t i{begin}; i < end; ++i)
+                {
+                    position[i] -= m_box[k] * std::floor(position[i] / m_box[k]);
+                    m_reference[k * count + i] = position[i];
+                }
+            }
+        });
+        m_domains.resize(domains(pool.size()));
+        const size_t threads{pool.size()};
+        pool.run([&](size_t thread) {
+            for (size_t d{thread}; d < m_domains.size(); d += threads)
+            {
+                partition(d);
+            }
+        });
+        m_valid = true;
+        ++m_builds;
+    }
+
+    /**
+     * Assign the reference positions to the slab of a domain and build its neighbor list
+     */
+    void partition(const size_t d)
+    {
+        const size_t count{m_reference.size() / 3U};
+        const size_t domains{m_domains.size()};
+        const float_t width{m_box[m_axis] / static_cast<float_t>(domains)};
+        const float_t* axis{m_reference.data() + m_axis * count};
+        Domain& domain{m_domains[d]};
+        domain.index.clear();
+        for (size_t i{0U}; i < count; ++i)
+        {
+            if (slab(axis[i], width, domains) == d)
+            {
+                domain.index.push_back(i);
+            }
+        }
+        domain.owned = domain.index.size();
+
+        // Halos of the next slab, the last domain takes them from the first one shifted by the box length
+        const size_t next{(d + 1U) % domains};
+        const float_t lower{static_cast<float_t>(next) * width};
+        for (size_t i{0U}; i < count; ++i)
+        {
+            if (slab(axis[i], width, domains) == next && axis[i] - lower < m_radius)
+            {
+                domain.index.push_back(i);
+            }
+        }
+
+        const size_t size{domain.index.size()};
+        gather(domain, d, m_reference.data(), count);
+        domain.force.assign(size * 3U, 0.F);
+        float_t box[3]{m_box[0], m_box[1], m_box[2]};
+        box[m_axis] = 0.F;
+        domain.neighbors.setCutoff(m_cutoff, m_skin);
+        domain.neighbors.setBox(box);
+        domain.neighbors.rebuild(size, [&domain, size](size_t i, size_t k) { return domain.position[k * size + i]; });
+    }
+
+    /**
+     * Calculate the forces of the owned particles and halos of a domain
+     */
+    void calculate(const size_t d, const Particles& particles, const lj::Parameters& parameters, const lj::Kernel kernel)
+    {
+        Domain& domain{m_domains[d]};
+        const size_t size{domain.index.size()};
+        const float_t* all[3]{particles.position(0U), particles.position(1U), particles.position(2U)};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            float_t* position{domain.position.data() + k * size};
+            for (size_t i{0U}; i < size; ++i)
+            {
+                position[i] = all[k][domain.index[i]];
+            }
+        }
+        shift(domain, d);
+        std::fill(domain.force.begin(), domain.force.end(), 0.F);
+
+        const float_t* position[3]{domain.position.data(), domain.position.data() + size, domain.position.data() + 2U * size};
+        float_t* force[3]{domain.force.data(), domain.force.data() + size, domain.force.data() + 2U * size};
+        domain.sums = kernel(parameters, domain.neighbors, 0U, domain.owned, position, force);
+    }
+
+    /**
+     * Store the forces of the owned particles of a domain and add those on the halos of the previous domain
+     */
+    void collect(const size_t d, Particles& particles) const
+    {
+        const Domain& domain{m_domains[d]};
+        const Domain& previous{m_domains[(d + m_domains.size() - 1U) % m_domains.size()]};
+        const size_t size{domain.index.size()};
+        const size_t halos{previous.index.size()};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            float_t* force{particles.force(k)};
+            const float_t* local{domain.force.data() + k * size};
+            for (size_t i{0U}; i < domain.owned; ++i)
+            {
+                force[domain.index[i]] = local[i];
+            }
+            const float_t* halo{previous.force.data() + k * halos};
+            for (size_t i{previous.owned}; i < halos; ++i)
+            {
+                force[previous.index[i]] += halo[i];
+            }
+        }
+    }
+
+    /**
+     * Copy positions of all particles into the local arrays of a domain
+     */
+    void gather(Domain& domain, const size_t d, const float_t* position, const size_t count) const
+    {
+        const size_t size{domain.index.size()};
+        domain.position.resize(size * 3U);
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            for (size_t i{0U}; i < size; ++i)
+            {
+                domain.position[k * size + i] = position[k * count + domain.index[i]];
+            }
+        }
+        shift(domain, d);
+    }
+
+    /**
+     * Shift the halos of the last domain, which are at the start of the box, behind its end
+     */
+    void shift(Domain& domain, const size_t d) const
+    {
+        if (d + 1U != m_domains.size())
+        {
+            return;
+        }
+        const size_t size{domain.index.size()};
+        float_t* position{domain.position.data() + m_axis * size};
+        for (size_t i{domain.owned}; i < size; ++i)
+        {
+            position[i] += m_box[m_axis];
+        }
+    }
+
+    /**
+     * Number of domains for a number of threads, each slab is at least as wide as the cutoff radius plus skin
+     */
+    [[nodiscard]] size_t domains(const size_t threads) const
+    {
+        return std::max<size_t>(1U, std::min(threads, static_cast<size_t>(m_box[m_axis] / m_radius)));
+    }
+
+    static size_t slab(const float_t r, const float_t width, const size_t domains)
+    {
+        return std::min(static_cast<size_t>(std::max(r, 0.F) / width), domains - 1U);
+    }
+
+    static constexpr size_t GRAIN{4096U}; //!< Particles per scheduled chunk
+
+    float_t m_box[3]{}; //!< Periodic box lengths
+    size_t m_axis{0U}; //!< Axis of the slabs, the longest one
+    float_t m_cutoff{100.F}; //!< Cutoff radius
+    float_t m_skin{10.F}; //!< Skin distance
+    float_t m_radius{110.F}; //!< Neighbor list radius, the minimum width of a slab
+    bool m_valid{false}; //!< Partition matches the particles
+    size_t m_builds{0U}; //!< Number of partitions
+    std::vector<float_t> m_reference{}; //!< Positions per axis at the last partition
+    std::vector<Domain> m_domains{};
+};
+}
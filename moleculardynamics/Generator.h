@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Particles.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace md
+{
+/**
+ * @brief Generators of initial conditions
+ *
+ * Create benchmark sized systems without input file. The particles are
+ * centered at the origin, the functions return the volume of their box.
+ */
+namespace generate
+{
+/**
+ * @brief Lattice types
+ */
+enum class Lattice
+{
+    Cubic, //!< Simple cubic, one particle per cell
+    Fcc //!< Face centered cubic, four particles per cell
+};
+
+/**
+ * Place particles on a lattice
+ * @param particles  Particles, resized to cells^3 times the particles per cell
+ * @param lattice    Lattice type
+ * @param cells      Number of cells per axis
+ * @param spacing    Distance of the nearest neighbors
+ * @param mass       Mass of each particle
+ * @return Volume of the lattice
+ */
+inline float_t lattice(Particles& particles, const Lattice lattice, const size_t cells, const float_t spacing, const float_t mass)
+{
+    static constexpr float_t CUBIC[1][3]{{0.F, 0.F, 0.F}};
+    static constexpr float_t FCC[4][3]{{0.F, 0.F, 0.F}, {0.F, .5F, .5F}, {.5F, 0.F, .5F}, {.5F, .5F, 0.F}};
+    const float_t(*basis)[3]{lattice == Lattice::Fcc ? FCC : CUBIC};
+    const size_t sites{lattice == Lattice::Fcc ? 4U : 1U};
+    const float_t constant{lattice == Lattice::Fcc ? spacing * std::sqrt(2.F) : spacing};
+    const float_t side{constant * static_cast<float_t>(cells)};
+
+    particles.resize(cells * cells * cells * sites);
+    float_t* position[3]{particles.position(0U), particles.position(1U), particles.position(2U)};
+    size_t i{0U};
+    for (size_t z{0U}; z < cells; ++z)
+    {
+        for (size_t y{0U}; y < cells; ++y)
+        {
+            for (size_t x{0U}; x < cells; ++x)
+            {
+                const size_t cell[3]{x, y, z};
+                for (size_t s{0U}; s < sites; ++s, ++i)
+                {
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        position[k][i] = (static_cast<float_t>(cell[k]) + basis[s][k]) * constant - .5F * side;
+                    }
+                }
+            }
+        }
+    }
+    std::fill(particles.mass(), particles.mass() + particles.size(), mass);
+    return side * side * side;
+}
+
+/**
+ * Place particles at random positions of a cube, no two particles are closer than minimum
+ * @param particles  Particles, resized to count or less if the cube is too dense
+ * @param count      Number of particles
+ * @param side       Side length of the cube
+ * @param minimum    Minimum distance of two particles
+ * @param mass       Mass of each particle
+ * @param seed       Seed of the random numbers
+ * @param periodic   Measure the distances as minimum images of a periodic cube
+ * @return Volume of the cube
+ */
+inline float_t gas(Particles& particles, const size_t count, const float_t side, const float_t minimum, const float_t mass, const uint32_t seed, const bool periodic = false)
+{
+    static constexpr size_t NONE{std::numeric_limits<size_t>::max()};
+    static constexpr size_t ATTEMPTS{100U}; //!< Attempts per particle before giving up
+
+    // Linked cells of at least the minimum distance
+    const size_t cells{std::max<size_t>(1U, std::min<size_t>(static_cast<size_t>(side / minimum), 1024U))};
+    const float_t size{side / static_cast<float_t>(cells)};
+    std::vector<size_t> head(cells * cells * cells, NONE);
+    std::vector<size_t> next(count, NONE);
+
+    particles.resize(count);
+    float_t* position[3]{particles.position(0U), particles.position(1U), particles.position(2U)};
+    std::mt19937 generator{seed};
+    std::uniform_real_distribution<float_t> distribution{0.F, side};
+    const float_t minimum2{minimum * minimum};
+    size_t placed{0U};
+    for (size_t attempt{0U}; placed < count && attempt < ATTEMPTS * count; ++attempt)
+    {
+        float_t r[3]{distribution(generator), distribution(generator), distribution(generator)};
+        size_t c[3]{};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            c[k] = std::min(static_cast<size_t>(r[k] / size), cells - 1U);
+        }
+
+        // Neighbor cells, which wrap around in a periodic cube, a cell may be visited twice if there are less than three per axis
+        bool free{true};
+        for (size_t n{0U}; free && n < 27U; ++n)
+        {
+            const size_t offset[3]{n % 3U, n / 3U % 3U, n / 9U};
+            size_t neighbor[3]{};
+            bool inside{true};
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                neighbor[k] = (c[k] + cells + offset[k] - 1U) % cells;
+                inside = inside && (periodic || c[k] + offset[k] - 1U < cells);
+            }
+            if (!inside)
+            {
+                continue;
+            }
+            for (size_t j{head[(neighbor[2] * cells + neighbor[1]) * cells + neighbor[0]]}; free && j != NONE; j = next[j])
+            {
+                float_t r2{0.F};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    float_t d{r[k] - position[k][j]};
+                    if (periodic)
+                    {
+                        d -= side * std::round(d / side);
+                    }
+                    r2 += d * d;
+                }
+                free = r2 >= minimum2;
+            }
+        }
+        if (free)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                position[k][placed] = r[k];
+            }
+            const size_t cell{(c[2] * cells + c[1]) * cells + c[0]};
+            next[placed] = head[cell];
+            head[cell] = placed++;
+        }
+    }
+
+    particles.resize(placed);
+    for (size_t k{0U}; k < 3U; ++k)
+    {
+        std::for_each(particles.position(k), particles.position(k) + placed, [side](float_t& r) { r -= .5F * side; });
+    }
+    std::fill(particles.mass(), particles.mass() + placed, mass);
+    return side * side * side;
+}
+
+/**
+ * Draw velocities from the Maxwell Boltzmann distribution
+ *
+ * The drift of the center of mass is removed and the velocities are scaled
+ * to the exact temperature 2 * Ekin / (3 * N * kB).
+ * @param particles    Particles with masses
+ * @param temperature  Temperature
+ * @param seed         Seed of the random numbers
+ */
+inline void maxwellBoltzmann(Particles& particles, const float_t temperature, const uint32_t seed)
+{
+    static constexpr float_t KB{1.F};
+    const size_t count{particles.size()};
+    const float_t* mass{particles.mass()};
+    if (count == 0U)
+    {
+        return;
+    }
+
+    std::mt19937 generator{seed};
+    std::normal_distribution<float_t> distribution{0.F, 1.F};
+    float_t total{0.F};
+    for (size_t i{0U}; i < count; ++i)
+    {
+        total += mass[i];
+    }
+    double kinetic{0.};
+    for (size_t k{0U}; k < 3U; ++k)
+    {
+        // Each component has the variance kB * T / m
+        float_t* velocity{particles.velocity(k)};
+        double momentum{0.};
+        for (size_t i{0U}; i < count; ++i)
+        {
+            velocity[i] = distribution(generator) * std::sqrt(KB * temperature / mass[i]);
+            momentum += mass[i] * velocity[i];
+        }
+        const auto drift = static_cast<float_t>(momentum / total);
+        for (size_t i{0U}; i < count; ++i)
+        {
+            velocity[i] -= drift;
+            kinetic += .5 * mass[i] * velocity[i] * velocity[i];
+        }
+    }
+
+    const double current{2. * kinetic / (3. * static_cast<double>(count) * KB)};
+    const auto scale = static_cast<float_t>(current > 0. ? std::sqrt(temperature / current) : 0.);
+    for (size_t k{0U}; k < 3U; ++k)
+    {
+        std::for_each(particles.velocity(k), particles.velocity(k) + count, [scale](float_t& v) { v *= scale; });
+    }
+}
+}
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "NeighborList.h"
+#include "ode/Simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace md
+{
+/**
+ * @brief Lennard Jones pair kernels
+ *
+ * The kernels accumulate the forces of the listed pairs (i, j) with i in
+ * [begin, end) and return their potential energy and virial. The vectorized kernels
+ * process 8 (AVX2) or 16 (AVX-512) neighbors of a particle per iteration with
+ * multiplications and a single reciprocal per pair. Forces and energy agree
+ * with the scalar kernel within a relative tolerance of 1e-5, the difference
+ * is due to the reciprocal and the summation order. The periodic variants
+ * take the minimum image of the distances on the axes with a box length.
+ */
+namespace lj
+{
+/**
+ * @brief Potential parameters
+ */
+struct Parameters
+{
+    float_t sigma2{40.F * 40.F}; //!< Square of the zero crossing distance
+    float_t epsilon{20.F}; //!< Depth of the potential well
+    float_t cutoff2{100.F * 100.F}; //!< Square of the cutoff radius
+    float_t box[3]{}; //!< Periodic box lengths, zero for open axes
+};
+
+//! Adding and subtracting 1.5 * 2^23 rounds to the nearest integer for values below 2^22
+static constexpr float_t ROUND{12582912.F};
+
+/**
+ * Return the minimum image of the distance d for a box length and its inverse, which are zero for an open axis
+ */
+inline float_t image(const float_t d, const float_t box, const float_t inverse)
+{
+    return d - box * ((d * inverse + ROUND) - ROUND);
+}
+
+/**
+ * @brief Sums over the pairs of a kernel call
+ */
+struct Sums
+{
+    float_t potential{0.F}; //!< Potential energy
+    float_t virial{0.F}; //!< Virial, sum of r_ij * F_ij
+
+    Sums& operator+=(const Sums& rhs)
+    {
+        potential += rhs.potential;
+        virial += rhs.virial;
+        return *this;
+    }
+};
+
+//! Kernel signature, position and force hold the arrays of the three axes
+using Kernel = Sums (*)(const Parameters& parameters, const NeighborList& neighbors, size_t begin, size_t end, const float_t* const* position, float_t* const* force);
+
+/**
+ * @brief Scalar kernel
+ */
+struct Scalar
+{
+    template<bool PERIODIC>
+    static Sums pairs(const Parameters& parameters, const NeighborList& neighbors, const size_t begin, const size_t end, const float_t* const* position, float_t* const* force)
+    {
+        const float_t scale{24.F * parameters.epsilon / parameters.sigma2};
+        float_t inverse[3]{};
+        for (size_t k{0U}; k < 3; ++k)
+        {
+            inverse[k] = parameters.box[k] > 0.F ? 1.F / parameters.box[k] : 0.F;
+        }
+        float_t potential{0.F};
+        float_t virial{0.F};
+        for (size_t i{begin}; i < end; ++i)
+        {
+            for (const size_t* it{neighbors.begin(i)}; it != neighbors.end(i); ++it)
+            {
+                const size_t j{*it};
+                float_t dr[3];
+                for (size_t k{0U}; k < 3; ++k)
+                {
+                    dr[k] = position[k][i] - position[k][j];
+                    if (PERIODIC)
+                    {
+                        dr[k] = image(dr[k], parameters.box[k], inverse[k]);
+                    }
+                }
+                const float_t r2{dr[0] * dr[0] + dr[1] * dr[1] + dr[2] * dr[2]};
+                if (r2 >= parameters.cutoff2)
+                {
+                    continue;
+                }
+                const float_t rho{parameters.sigma2 / r2};
+                const float_t rho3{rho * rho * rho};
+                const float_t pot{(2.F * rho3 - 1.F) * rho3 * rho};
+                for (size_t k{0U}; k < 3; ++k)
+                {
+                    force[k][i] += scale * pot * dr[k];
+                    force[k][j] -= scale * pot * dr[k];
+                }
+                potential += (rho3 - 1.F) * rho3;
+                virial += (2.F * rho3 - 1.F) * rho3;
+            }
+        }
+        return {4.F * parameters.epsilon * potential, 24.F * parameters.epsilon * virial};
+    }
+};
+
+#ifdef ODE_SIMD_X86
+/**
+ * @brief Generic kernel on vectors of BYTES size
+ *
+ * The neighbor positions are gathered into vectors, the forces on the
+ * neighbors are scattered back lane by lane. Lanes past the last neighbor
+ * are placed beyond the cutoff radius.
+ */
+template<typename T, typename I, size_t BYTES>
+struct Pack
+{
+    typedef T Type __attribute__((vector_size(BYTES)));
+    typedef I Mask __attribute__((vector_size(BYTES)));
+    static constexpr size_t WIDTH{BYTES / sizeof(T)};
+
+    template<bool PERIODIC>
+    __attribute__((always_inline)) static inline Sums pairs(const Parameters& parameters, const NeighborList& neighbors, const size_t begin, const size_t end, const float_t* const* position, float_t* const* force)
+    {
+        const float_t scale{24.F * parameters.epsilon / parameters.sigma2};
+        float_t inverse[3]{};
+        for (size_t k{0U}; k < 3; ++k)
+        {
+            inverse[k] = parameters.box[k] > 0.F ? 1.F / parameters.box[k] : 0.F;
+        }
+        const float_t far{2.F * parameters.cutoff2 + 1.F};
+        const Type zero{};
+        const Type farther{zero + far};
+        Mask lane{};
+        for (size_t l{0U}; l < WIDTH; ++l)
+        {
+            lane[l] = static_cast<I>(l);
+        }
+        Type potential{};
+        Type virial{};
+        for (size_t i{begin}; i < end; ++i)
+        {
+            const size_t* first{neighbors.begin(i)};
+            const size_t count{static_cast<size_t>(neighbors.end(i) - first)};
+            Type fi[3]{};
+            for (size_t n{0U}; n < count; n += WIDTH)
+            {
+                const size_t lanes{count - n < WIDTH ? count - n : WIDTH};
+                float_t gather[3][WIDTH];
+                for (size_t l{0U}; l < WIDTH; ++l)
+                {
+                    for (size_t k{0U}; k < 3; ++k)
+                    {
+                        gather[k][l] = l < lanes ? position[k][i] - position[k][first[n + l]] : far;
+                    }
+                }
+                Type dr[3];
+                for (size_t k{0U}; k < 3; ++k)
+                {
+                    std::memcpy(&dr[k], gather[k], BYTES);
+                    if (PERIODIC)
+                    {
+                        // Minimum image, see image()
+                        dr[k] -= parameters.box[k] * ((dr[k] * inverse[k] + ROUND) - ROUND);
+                    }
+                }
+                if (PERIODIC && lanes < WIDTH)
+                {
+                    // The image moved the lanes past the last neighbor, place them beyond the cutoff radius again
+                    dr[0] = lane < static_cast<I>(lanes) ? dr[0] : farther;
+                }
+                const Type r2{dr[0] * dr[0] + dr[1] * dr[1] + dr[2] * dr[2]};
+                const Mask inside{r2 < parameters.cutoff2};
+                const Type rho{parameters.sigma2 * (1.F / r2)};
+                const Type rho3{rho * rho * rho};
+                const Type pot{inside ? scale * (2.F * rho3 - 1.F) * rho3 * rho : zero};
+                potential += inside ? (rho3 - 1.F) * rho3 : zero;
+                virial += inside ? (2.F * rho3 - 1.F) * rho3 : zero;
+                for (size_t k{0U}; k < 3; ++k)
+                {
+                    const Type f{pot * dr[k]};
+                    fi[k] += f;
+                    for (size_t l{0U}; l < lanes; ++l)
+                    {
+                        force[k][first[n + l]] -= f[l];
+                    }
+                }
+            }
+            for (size_t k{0U}; k < 3; ++k)
+            {
+                float_t sum{0.F};
+                for (size_t l{0U}; l < WIDTH; ++l)
+                {
+                    sum += fi[k][l];
+                }
+                force[k][i] += sum;
+            }
+        }
+        Sums sums{};
+        for (size_t l{0U}; l < WIDTH; ++l)
+        {
+            sums.potential += potential[l];
+            sums.virial += virial[l];
+        }
+        return {4.F * parameters.epsilon * sums.potential, 24.F * parameters.epsilon * sums.virial};
+    }
+};
+
+/**
+ * @brief AVX2 kernel with 8 lanes
+ */
+struct Avx2
+{
+    template<bool PERIODIC>
+    __attribute__((target("avx2,fma"), flatten)) static Sums pairs(const Parameters& parameters, const NeighborList& neighbors, const size_t begin, const size_t end, const float_t* const* position, float_t* const* force)
+    {
+        return Pack<float_t, int32_t, 32U>::template pairs<PERIODIC>(parameters, neighbors, begin, end, position, force);
+    }
+};
+
+/**
+ * @brief AVX-512 kernel with 16 lanes
+ */
+struct Avx512
+{
+    template<bool PERIODIC>
+    __attribute__((target("avx512f"), flatten)) static Sums pairs(const Parameters& parameters, const NeighborList& neighbors, const size_t begin, const size_t end, const float_t* const* position, float_t* const* force)
+    {
+        return Pack<float_t, int32_t, 64U>::template pairs<PERIODIC>(parameters, neighbors, begin, end, position, force);
+    }
+};
+#endif
+
+/**
+ * Return the kernel of the best supported instruction set, the scalar kernel if vectorized is false
+ * @param vectorized Vectorized kernel if supported
+ * @param periodic   Minimum image distances on the axes with a box length
+ */
+inline Kernel kernel(const bool vectorized, const bool periodic = false)
+{
+#ifdef ODE_SIMD_X86
+    if (vectorized)
+    {
+        static const ode::simd::Isa isa{ode::simd::detect()};
+        if (isa == ode::simd::Isa::Avx512)
+        {
+            return periodic ? Avx512::pairs<true> : Avx512::pairs<false>;
+        }
+        if (isa == ode::simd::Isa::Avx2)
+        {
+            return periodic ? Avx2::pairs<true> : Avx2::pairs<false>;
+        }
+    }
+#else
+    static_cast<void>(vectorized);
+#endif
+    return periodic ? Scalar::pairs<true> : Scalar::pairs<false>;
+}
+}
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace md
+{
+/**
+ * NeighborList class
+ *
+ * Verlet list of the pairs within the cutoff radius plus a skin distance.
+ * The list is built from a linked cell grid with cells of the list radius,
+ * so building and traversing scale linearly with the number of particles.
+ * It is only rebuilt after a particle moved more than half the skin since
+ * the last build. Axes with a box length are periodic, their distances are
+ * minimum images and their cells wrap around.
+ */
+class NeighborList
+{
+public:
+    NeighborList() = default;
+
+    /**
+     * Set cutoff radius and skin distance
+     */
+    void setCutoff(const float_t cutoff, const float_t skin)
+    {
+        m_cutoff = cutoff;
+        m_skin = skin;
+        m_valid = false;
+    }
+
+    /**
+     * Set periodic box lengths of the three axes, zero for an open axis
+     *
+     * Periodic lengths must be at least twice the cutoff radius plus skin.
+     */
+    void setBox(const float_t* box)
+    {
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            m_box[k] = box[k];
+        }
+        m_valid = false;
+    }
+
+    [[nodiscard]] float_t cutoff() const
+    {
+        return m_cutoff;
+    }
+
+    [[nodiscard]] float_t skin() const
+    {
+        return m_skin;
+    }
+
+    /**
+     * Number of list builds
+     */
+    [[nodiscard]] size_t builds() const
+    {
+        return m_builds;
+    }
+
+    /**
+     * Rebuild the list if required
+     * @param count      Number of particles
+     * @param position   Position accessor position(i, k) of particle i and axis k
+     * @return true if the list was rebuilt
+     */
+    template<typename P>
+    bool update(const size_t count, P&& position)
+    {
+        if (m_valid && count == m_count && !moved(position))
+        {
+            return false;
+        }
+        build(count, position);
+        return true;
+    }
+
+    /**
+     * Rebuild the list
+     */
+    template<typename P>
+    void rebuild(const size_t count, P&& position)
+    {
+        build(count, position);
+    }
+
+    /**
+     * Call pair(i, j) for every listed pair with i < j
+     */
+    template<typename F>
+    void forEach(F&& pair) const
+    {
+        for (size_t i{0U}; i < m_count; ++i)
+        {
+            for (size_t n{m_offsets[i]}; n < m_offsets[i + 1U]; ++n)
+            {
+                pair(i, m_neighbors[n]);
+            }
+        }
+    }
+
+    /**
+     * Neighbors j > i of particle i
+     */
+    [[nodiscard]] const size_t* begin(const size_t i) const
+    {
+        return m_neighbors.data() + m_offsets[i];
+    }
+
+    [[nodiscard]] const size_t* end(const size_t i) const
+    {
+        return m_neighbors.data() + m_offsets[i + 1U];
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_neighbors.size();
+    }
+
+    /**
+     * Save distances, box and the positions of the last build, see ode/Checkpoint.h
+     */
+    template<typename A>
+    void write(A& archive) const
+    {
+        archive.write(m_cutoff);
+        archive.write(m_skin);
+        archive.write(m_box, 3U);
+        archive.write(static_cast<uint64_t>(m_valid ? m_count : 0U));
+        archive.write(static_cast<uint64_t>(m_builds));
+        archive.write(m_reference);
+    }
+
+    /**
+     * Restore distances and rebuild the list from the saved positions, so it equals the saved list
+     */
+    template<typename A>
+    bool read(A& archive)
+    {
+        uint64_t count{0U};
+        uint64_t builds{0U};
+        std::vector<float_t> reference{};
+        if (!archive.read(m_cutoff) || !archive.read(m_skin) || !archive.read(m_box, 3U) || !archive.read(count) || !archive.read(builds) || !archive.read(reference) || reference.size() < count * 3U)
+        {
+            return false;
+        }
+        m_valid = false;
+        if (count > 0U)
+        {
+            auto position = [&reference](size_t i, size_t k) { return reference[i * 3U + k]; };
+            build(count, position);
+        }
+        m_builds = builds;
+        return true;
+    }
+
+private:
+    template<typename P>
+    bool moved(P& position) const
+    {
+        const float_t limit{.25F * m_skin * m_skin};
+        for (size_t i{0U}; i < m_count; ++i)
+        {
+            float_t r2{0.F};
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                const float_t d{image(position(i, k) - m_reference[i * 3U + k], k)};
+                r2 += d * d;
+            }
+            if (r2 > limit)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename P>
+    void build(const size_t count, P& position)
+    {
+        m_count = count;
+        m_valid = true;
+        ++m_builds;
+        m_reference.resize(count * 3U);
+        m_offsets.assign(count + 1U, 0U);
+        m_neighbors.clear();
+        if (count == 0U)
+        {
+            return;
+        }
+
+        // Bounding box
+        float_t lower[3]{std::numeric_limits<float_t>::max(), std::numeric_limits<float_t>::max(), std::numeric_limits<float_t>::max()};
+        float_t upper[3]{std::numeric_limits<float_t>::lowest(), std::numeric_limits<float_t>::lowest(), std::numeric_limits<float_t>::lowest()};
+        for (size_t i{0U}; i < count; ++i)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                const float_t r{position(i, k)};
+                m_reference[i * 3U + k] = r;
+                lower[k] = std::min(lower[k], r);
+                upper[k] = std::max(upper[k], r);
+            }
+        }
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            if (m_box[k] > 0.F)
+            {
+                lower[k] = 0.F;
+                upper[k] = m_box[k];
+            }
+        }
+
+        // Cells of at least the list radius, sparse systems get larger cells. The
+        // counts are calculated in double and clamped per axis, so infinite or
+        // invalid extents get a single cell and the product can't wrap around
+        const float_t radius{m_cutoff + m_skin};
+        const double limit{2. * static_cast<double>(count) + 27.};
+        double size{radius};
+        size_t cells[3]{1U, 1U, 1U};
+        for (;;)
+        {
+            double total{1.};
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                const double extent{(static_cast<double>(upper[k]) - lower[k]) / size};
+                const double n{std::isfinite(extent) ? std::clamp(std::floor(extent), 1., limit) : 1.};
+                cells[k] = static_cast<size_t>(n);
+                total *= n;
+            }
+            if (total <= limit)
+            {
+                break;
+            }
+            size *= 2.;
+        }
+
+        // Linked cells
+        m_head.assign(cells[0] * cells[1] * cells[2], NONE);
+        m_next.resize(count);
+        m_cell.resize(count * 3U);
+        for (size_t i{count}; i-- > 0U;)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                const float_t r{m_box[k] > 0.F ? m_reference[i * 3U + k] - m_box[k] * std::floor(m_reference[i * 3U + k] / m_box[k]) : m_reference[i * 3U + k]};
+                // Positions beyond the last cell, infinite or invalid ones go into the last cell
+                const double c{std::max(static_cast<double>(r) - lower[k], 0.) / size};
+                m_cell[i * 3U + k] = c < static_cast<double>(cells[k] - 1U) ? static_cast<size_t>(c) : cells[k] - 1U;
+            }
+            const size_t cell{index(&m_cell[i * 3U], cells)};
+            m_next[i] = m_head[cell];
+            m_head[cell] = i;
+        }
+
+        // Pairs within the list radius from the neighboring cells
+        const float_t radius2{radius * radius};
+        for (size_t i{0U}; i < count; ++i)
+        {
+            // Neighboring cells of each axis, periodic axes wrap around
+            size_t range[3][3]{};
+            size_t ranges[3]{};
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                const size_t c{m_cell[i * 3U + k]};
+                if (m_box[k] > 0.F && cells[k] >= 3U)
+                {
+                    range[k][0] = (c + cells[k] - 1U) % cells[k];
+                    range[k][1] = c;
+                    range[k][2] = (c + 1U) % cells[k];
+                    ranges[k] = 3U;
+                }
+                else
+                {
+                    for (size_t n{m_box[k] > 0.F || c == 0U ? 0U : c - 1U}; n <= (m_box[k] > 0.F ? cells[k] - 1U : std::min(c + 1U, cells[k] - 1U)); ++n)
+                    {
+                        range[k][ranges[k]++] = n;
+                    }
+                }
+            }
+            size_t neighbor[3]{};
+            for (size_t x{0U}; x < ranges[0]; ++x)
+            {
+                neighbor[0] = range[0][x];
+                for (size_t y{0U}; y < ranges[1]; ++y)
+                {
+                    neighbor[1] = range[1][y];
+                    for (size_t z{0U}; z < ranges[2]; ++z)
+                    {
+                        neighbor[2] = range[2][z];
+                        for (size_t j{m_head[index(neighbor, cells)]}; j != NONE; j = m_next[j])
+                        {
+                            if (j <= i)
+                            {
+                                continue;
+                            }
+                            float_t r2{0.F};
+                            for (size_t k{0U}; k < 3U; ++k)
+                            {
+                                const float_t d{image(m_reference[i * 3U + k] - m_reference[j * 3U + k], k)};
+                                r2 += d * d;
+                            }
+                            if (r2 < radius2)
+                            {
+                                m_neighbors.push_back(j);
+                            }
+                        }
+                    }
+                }
+            }
+            m_offsets[i + 1U] = m_neighbors.size();
+        }
+    }
+
+    /**
+     * Minimum image of the distance d on axis k
+     */
+    [[nodiscard]] float_t image(const float_t d, const size_t k) const
+    {
+        return m_box[k] > 0.F ? d - m_box[k] * std::nearbyint(d / m_box[k]) : d;
+    }
+
+    static size_t index(const size_t* cell, const size_t* cells)
+    {
+        return (cell[2] * cells[1] + cell[1]) * cells[0] + cell[0];
+    }
+
+    static constexpr size_t NONE{std::numeric_limits<size_t>::max()};
+
+    float_t m_cutoff{100.F}; //!< Cutoff radius
+    float_t m_skin{10.F}; //!< Skin distance
+    float_t m_box[3]{}; //!< Periodic box lengths, zero for open axes
+    bool m_valid{false}; //!< List matches the particles
+    size_t m_count{0U}; //!< Number of particles
+    size_t m_builds{0U}; //!< Number of builds
+    std::vector<float_t> m_reference{}; //!< Positions at the last build
+    std::vector<size_t> m_offsets{}; //!< First neighbor of each particle
+    std::vector<size_t> m_neighbors{}; //!< Neighbors j > i of all particles i
+    std::vector<size_t> m_head{}; //!< First particle of each cell
+    std::vector<size_t> m_next{}; //!< Next particle in the same cell
+    std::vector<size_t> m_cell{}; //!< Cell coordinates of each particle
+};
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "LennardJones.h"
+#include <cmath>
+#include <cstddef>
+
+namespace md
+{
+/**
+ * Statistics class
+ *
+ * Running mean and variance of a series of values (Welford's algorithm).
+ */
+class Statistics
+{
+public:
+    Statistics() = default;
+
+    void add(const double value)
+    {
+        ++m_count;
+        const double delta{value - m_mean};
+        m_mean += delta / static_cast<double>(m_count);
+        m_m2 += delta * (value - m_mean);
+    }
+
+    [[nodiscard]] size_t count() const
+    {
+        return m_count;
+    }
+
+    [[nodiscard]] double mean() const
+    {
+        return m_mean;
+    }
+
+    /**
+     * Sample variance, zero for less than two values
+     */
+    [[nodiscard]] double variance() const
+    {
+        return m_count > 1U ? m_m2 / static_cast<double>(m_count - 1U) : 0.;
+    }
+
+private:
+    size_t m_count{0U};
+    double m_mean{0.};
+    double m_m2{0.}; //!< Sum of the squared differences from the mean
+};
+
+/**
+ * Observables class
+ *
+ * Thermodynamic observables of a step. The potential energy and the virial
+ * are summed by the force pass, the kinetic energy and the momentum by the
+ * last velocity pass of the integrator, so they need no extra sweep over the
+ * particles. complete() derives the total energy, temperature and pressure
+ * and adds the step to the running statistics.
+ */
+class Observables
+{
+public:
+    /**
+     * @brief Observable quantities
+     */
+    enum Quantity : size_t
+    {
+        Kinetic, //!< Kinetic energy
+        Potential, //!< Potential energy
+        Total, //!< Total energy
+        Temperature, //!< Temperature 2 * Ekin / (3 * N * kB)
+        Pressure, //!< Virial pressure (2 * Ekin + W) / (3 * V)
+        Quantities
+    };
+
+    Observables() = default;
+
+    /**
+     * Clear the sums of the step, called before the passes
+     */
+    void reset()
+    {
+        m_kinetic = 0.F;
+        m_forces = lj::Sums{};
+        for (auto& momentum : m_momentum)
+        {
+            momentum = 0.F;
+        }
+    }
+
+    /**
+     * Add velocity of axis k of a particle
+     */
+    void addVelocity(const size_t k, const float_t mass, const float_t velocity)
+    {
+        const float_t momentum{mass * velocity};
+        m_kinetic += .5F * momentum * velocity;
+        m_momentum[k] += momentum;
+    }
+
+    /**
+     * Add sums of the force pass
+     */
+    void addForces(const lj::Sums& sums)
+    {
+        m_forces += sums;
+    }
+
+    /**
+     * Derive the observables of the step and add them to the statistics
+     * @param count      Number of particles
+     * @param volume     Volume of the system, the pressure is zero without volume
+     */
+    void complete(const size_t count, const float_t volume)
+    {
+        static constexpr float_t KB{1.F};
+        m_values[Kinetic] = m_kinetic;
+        m_values[Potential] = m_forces.potential;
+        m_values[Total] = m_kinetic + m_forces.potential;
+        m_values[Temperature] = count > 0U ? 2.F * m_kinetic / (3.F * static_cast<float_t>(count) * KB) : 0.F;
+        m_values[Pressure] = volume > 0.F ? (2.F * m_kinetic + m_forces.virial) / (3.F * volume) : 0.F;
+        for (size_t q{0U}; q < Quantities; ++q)
+        {
+            m_statistics[q].add(m_values[q]);
+        }
+    }
+
+    /**
+     * Return the name of a quantity
+     */
+    static const char* name(const Quantity quantity)
+    {
+        static constexpr const char* NAMES[Quantities]{"Kinetic energy", "Potential energy", "Total energy", "Temperature", "Pressure"};
+        return NAMES[quantity];
+    }
+
+    /**
+     * Value of the last completed step
+     */
+    [[nodiscard]] float_t value(const Quantity quantity) const
+    {
+        return m_values[quantity];
+    }
+
+    [[nodiscard]] const Statistics& statistics(const Quantity quantity) const
+    {
+        return m_statistics[quantity];
+    }
+
+    /**
+     * Total momentum of axis k
+     */
+    [[nodiscard]] float_t momentum(const size_t k) const
+    {
+        return m_momentum[k];
+    }
+
+private:
+    float_t m_kinetic{0.F}; //!< Kinetic energy of the step
+    lj::Sums m_forces{}; //!< Potential energy and virial of the step
+    float_t m_momentum[3]{}; //!< Total momentum of the step
+    float_t m_values[Quantities]{}; //!< Observables of the last completed step
+    Statistics m_statistics[Quantities]{}; //!< Running statistics of all completed steps
+};
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace md
+{
+/**
+ * Particles class
+ *
+ * Particle state in structure of arrays layout, each axis of the positions,
+ * velocities and forces and the masses are contiguous arrays. Solvers update
+ * the arrays in place, see ode::VelocityVerlet::advance.
+ */
+class Particles
+{
+public:
+    Particles() = default;
+
+    /**
+     * Resize to count particles, new particles are zero
+     */
+    void resize(const size_t count)
+    {
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            m_position[k].resize(count, 0.F);
+            m_velocity[k].resize(count, 0.F);
+            m_force[k].resize(count, 0.F);
+        }
+        m_mass.resize(count, 0.F);
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_mass.size();
+    }
+
+    /**
+     * Positions of axis k
+     */
+    [[nodiscard]] float_t* position(const size_t k)
+    {
+        return m_position[k].data();
+    }
+
+    [[nodiscard]] const float_t* position(const size_t k) const
+    {
+        return m_position[k].data();
+    }
+
+    /**
+     * Velocities of axis k
+     */
+    [[nodiscard]] float_t* velocity(const size_t k)
+    {
+        return m_velocity[k].data();
+    }
+
+    [[nodiscard]] const float_t* velocity(const size_t k) const
+    {
+        return m_velocity[k].data();
+    }
+
+    /**
+     * Forces of axis k
+     */
+    [[nodiscard]] float_t* force(const size_t k)
+    {
+        return m_force[k].data();
+    }
+
+    [[nodiscard]] const float_t* force(const size_t k) const
+    {
+        return m_force[k].data();
+    }
+
+    [[nodiscard]] float_t* mass()
+    {
+        return m_mass.data();
+    }
+
+    [[nodiscard]] const float_t* mass() const
+    {
+        return m_mass.data();
+    }
+
+    /**
+     * Save all arrays, see ode/Checkpoint.h
+     */
+    template<typename A>
+    void write(A& archive) const
+    {
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            archive.write(m_position[k]);
+            archive.write(m_velocity[k]);
+            archive.write(m_force[k]);
+        }
+        archive.write(m_mass);
+    }
+
+    template<typename A>
+    bool read(A& archive)
+    {
+        bool valid{true};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            valid = valid && archive.read(m_position[k]) && archive.read(m_velocity[k]) && archive.read(m_force[k]);
+        }
+        valid = valid && archive.read(m_mass);
+        for (size_t k{0U}; valid && k < 3U; ++k)
+        {
+            valid = m_position[k].size() == m_mass.size() && m_velocity[k].size() == m_mass.size() && m_force[k].size() == m_mass.size();
+        }
+        return valid;
+    }
+
+private:
+    std::vector<float_t> m_position[3]{}; //!< Positions per axis
+    std::vector<float_t> m_velocity[3]{}; //!< Velocities per axis
+    std::vector<float_t> m_force[3]{}; //!< Forces per axis
+    std::vector<float_t> m_mass{}; //!< Masses
+};
+}
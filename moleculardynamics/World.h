@@ -0,0 +1,555 @@
+#pragma once
+
+#include "Domains.h"
+#include "LennardJones.h"
+#include "NeighborList.h"
+#include "Observables.h"
+#include "Particles.h"
+#include "ode/Checkpoint.h"
+#include "ode/FrameWriter.h"
+#include "ode/TextReader.h"
+#include "ode/ThreadPool.h"
+#include "ode/VelocityVerlet.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace md
+{
+using Vector3 = ode::Vector<float_t, 3>;
+using VelocityVerlet = ode::VelocityVerlet<float_t>;
+using FrameWriter = ode::FrameWriter<float_t>;
+
+/**
+ * Body class
+ */
+class Body
+{
+public:
+    Body() = default;
+    Vector3 position{}; //!< Position vector
+    Vector3 velocity{}; //!< Velocity vector
+    Vector3 force{}; //!< Force vector
+    float_t mass{0.F}; //!< Mass
+};
+
+/**
+ * World class
+ */
+class World
+{
+public:
+    World() = default;
+
+    void step(const float_t t, const float_t dt)
+    {
+        // Calculate new values and observables
+        integrate(t, dt);
+
+        // Print results to files
+        print();
+
+        // Emit observables
+        if (m_frames % m_observableInterval == 0U)
+        {
+            for (auto& observer : m_observers)
+            {
+                observer(m_frames, m_observables);
+            }
+        }
+
+        // Save checkpoint
+        if (m_checkpointInterval > 0U && m_frames % m_checkpointInterval == 0U)
+        {
+            checkpoint(m_checkpointFile);
+        }
+    }
+
+    /**
+     * Integrate the particles and calculate the observables without output, the
+     * forces of the first step are calculated after the particles or the box changed
+     */
+    void integrate(const float_t t, const float_t dt)
+    {
+        if (!m_forcesValid)
+        {
+            lennardJones();
+        }
+        const float_t* mass{m_particles.mass()};
+        m_observables.reset();
+        m_solver.advance(
+            t, dt, m_particles, [this]([[maybe_unused]] float_t x) { lennardJones(); },
+            [this, mass](size_t k, size_t i, float_t velocity) { m_observables.addVelocity(k, mass[i], velocity); });
+        m_observables.complete(m_particles.size(), m_volume);
+        m_time = t + dt;
+    }
+
+    /**
+     * Add an observer, which is called as observer(frame, observables) every interval steps
+     */
+    void addObserver(std::function<void(size_t, const Observables&)> observer)
+    {
+        m_observers.push_back(std::move(observer));
+    }
+
+    /**
+     * Set steps between the calls of the observers
+     */
+    void setObservableInterval(const size_t interval)
+    {
+        m_observableInterval = std::max<size_t>(interval, 1U);
+    }
+
+    [[nodiscard]] const Observables& observables() const
+    {
+        return m_observables;
+    }
+
+    /**
+     * Set volume of the pressure, initialize sets the volume of the bounding box of the particles
+     */
+    void setVolume(const float_t volume)
+    {
+        m_volume = volume;
+    }
+
+    void print()
+    {
+        const float_t* x{m_particles.position(0U)};
+        const float_t* y{m_particles.position(1U)};
+        const float_t* z{m_particles.position(2U)};
+        for (size_t i{0U}; i < m_particles.size(); ++i)
+        {
+            if (m_rangeX[0] > x[i])
+            {
+                m_rangeX[0] = x[i];
+            }
+            if (m_rangeX[1] < x[i])
+            {
+                m_rangeX[1] = x[i];
+            }
+            if (m_rangeY[0] > y[i])
+            {
+                m_rangeY[0]= y[i];
+            }
+            if (m_rangeY[1] < y[i])
+            {
+                m_rangeY[1] = y[i];
+            }
+        }
+        m_frames++;
+
+        // Formatted and written by the writer thread
+        m_writer.push(m_time, m_particles.size() * 3U, [&](float_t* values) {
+            for (size_t i{0U}; i < m_particles.size(); ++i)
+            {
+                *values++ = x[i];
+                *values++ = y[i];
+                *values++ = z[i];
+            }
+        });
+    }
+
+    /**
+     * Set behaviour of the trajectory output if the disk falls behind
+     */
+    void setOutputPolicy(const FrameWriter::Policy policy)
+    {
+        m_writer.setPolicy(policy);
+    }
+
+    /**
+     * Write the trajectory in the binary format of ode/Trajectory.h instead of text, must be called before initialize
+     * @param binary     Binary output
+     * @param dt         Time step stored in the file header
+     */
+    void setBinaryOutput(const bool binary, const float_t dt)
+    {
+        m_binary = binary;
+        m_timeStep = dt;
+    }
+
+    /**
+     * Initialize world from a text file and open the output, the numbers are parsed by the thread pool
+     */
+    bool initialize(const std::string& filename)
+    {
+        ode::TextReader<float_t> reader{};
+        uint32_t count{0U};
+        std::vector<float_t> values{};
+        // Each number takes at least a byte, larger counts are invalid
+        if (reader.open(filename) && reader.read(count) && static_cast<size_t>(count) <= reader.remaining() / 4U)
+        {
+            std::cout << "Number of bodies = " << count << std::endl;
+            values.resize(static_cast<size_t>(count) * 4U);
+        }
+        if (values.empty() || !reader.read(values.data(), values.size(), m_pool.get()))
+        {
+            std::cout << "Invalid file " << filename.c_str() << std::endl;
+            return false;
+        }
+
+        // Rows of position and mass
+        m_particles.resize(count);
+        m_pool->parallelFor(count, GRAIN, [&](size_t, size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i)
+            {
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    m_particles.position(k)[i] = values[i * 4U + k];
+                }
+                m_particles.mass()[i] = values[i * 4U + 3U];
+            }
+        });
+        m_volume = boundingVolume();
+        m_forcesValid = false;
+        return openOutput();
+    }
+
+    /**
+     * Save periodic checkpoints
+     * @param interval   Steps between checkpoints, zero for none
+     * @param filename   Checkpoint file, replaced by each checkpoint
+     */
+    void setCheckpoint(const size_t interval, const std::string& filename)
+    {
+        m_checkpointInterval = interval;
+        m_checkpointFile = filename;
+    }
+
+    /**
+     * Save the complete state in the background, the caller only copies the state
+     * @return false if the checkpoint was skipped because the previous ones are still written
+     */
+    bool checkpoint(const std::string& filename)
+    {
+        return m_checkpoints.save(filename, CHECKPOINT, [this](ode::Archive& archive) {
+            m_particles.write(archive);
+            m_neighbors.write(archive);
+            archive.write(m_parameters);
+            m_domains.write(archive);
+            archive.write(m_observables);
+            archive.write(m_volume);
+            archive.write(m_time);
+            archive.write(static_cast<uint64_t>(m_frames));
+            archive.write(m_rangeX, 2U);
+            archive.write(m_rangeY, 2U);
+            archive.write(m_forcesValid);
+        });
+    }
+
+    /**
+     * Wait until all checkpoints are written
+     */
+    void waitCheckpoints()
+    {
+        m_checkpoints.wait();
+    }
+
+    /**
+     * Restore the state of a checkpoint, the run continues as it would have from the checkpoint
+     * given the same number of threads and kernel
+     */
+    bool restore(const std::string& filename)
+    {
+        ode::Archive archive{};
+        uint64_t frames{0U};
+        if (archive.load(filename, CHECKPOINT) && m_particles.read(archive) && m_neighbors.read(archive) && archive.read(m_parameters) && setBox(m_parameters.box) && m_domains.read(archive) && archive.read(m_observables) && archive.read(m_volume) && archive.read(m_time) && archive.read(frames) && archive.read(m_rangeX, 2U) && archive.read(m_rangeY, 2U) && archive.read(m_forcesValid))
+        {
+            m_frames = frames;
+            std::cout << "Number of bodies = " << m_particles.size() << ", time = " << m_time << std::endl;
+            return true;
+        }
+        std::cout << "Invalid checkpoint " << filename.c_str() << std::endl;
+        return false;
+    }
+
+    /**
+     * Open the trajectory output, called by initialize or after restore
+     * @return false if the output file can't be opened
+     */
+    bool openOutput()
+    {
+        const std::string filename{m_binary ? "Moleculesystem.trj" : "Moleculesystem.dat"};
+        const bool opened{m_binary ? m_writer.openBinary(filename, 0U, m_particles.size() * 3U, 3U, m_timeStep) : m_writer.open(filename, 0U, m_particles.size() * 3U)};
+        if (!opened)
+        {
+            std::cout << "Cannot open output " << filename.c_str() << std::endl;
+        }
+        return opened;
+    }
+
+    [[nodiscard]] float_t time() const
+    {
+        return m_time;
+    }
+
+    /**
+     * Initialize world with the given bodies without output file
+     */
+    void initialize(const std::vector<Body>& bodies)
+    {
+        m_particles.resize(bodies.size());
+        for (size_t i{0U}; i < bodies.size(); ++i)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                m_particles.position(k)[i] = bodies[i].position[k];
+                m_particles.velocity(k)[i] = bodies[i].velocity[k];
+                m_particles.force(k)[i] = bodies[i].force[k];
+            }
+            m_particles.mass()[i] = bodies[i].mass;
+        }
+        m_volume = boundingVolume();
+        m_forcesValid = false;
+    }
+
+    /**
+     * Initialize world with the given particles without output file, see Generator.h
+     */
+    void initialize(Particles&& particles)
+    {
+        m_particles = std::move(particles);
+        m_volume = boundingVolume();
+        m_forcesValid = false;
+    }
+
+    [[nodiscard]] Particles& particles()
+    {
+        return m_particles;
+    }
+
+    [[nodiscard]] const Particles& particles() const
+    {
+        return m_particles;
+    }
+
+    /**
+     * Set cutoff radius of the Lennard Jones potential and skin distance of the neighbor list
+     * @return false if a periodic length is less than twice the cutoff radius plus skin, nothing is changed then
+     */
+    bool setCutoff(const float_t cutoff, const float_t skin)
+    {
+        if (!m_domains.setBox(m_parameters.box, cutoff, skin))
+        {
+            return false;
+        }
+        m_neighbors.setCutoff(cutoff, skin);
+        m_parameters.cutoff2 = cutoff * cutoff;
+        m_forcesValid = false;
+        return true;
+    }
+
+    /**
+     * Set periodic box, which is decomposed into a slab per thread, see Domains.h
+     * @param box        Box lengths of the three axes, zeros for an open system
+     * @return false if a length is less than twice the cutoff radius plus skin
+     */
+    bool setBox(const float_t* box)
+    {
+        if (!m_domains.setBox(box, m_neighbors.cutoff(), m_neighbors.skin()))
+        {
+            return false;
+        }
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            m_parameters.box[k] = box[k];
+        }
+        m_kernel = lj::kernel(m_vectorized, m_domains.periodic());
+        if (m_domains.periodic())
+        {
+            m_volume = box[0] * box[1] * box[2];
+        }
+        m_forcesValid = false;
+        return true;
+    }
+
+    [[nodiscard]] const Domains& domains() const
+    {
+        return m_domains;
+    }
+
+    [[nodiscard]] const NeighborList& neighbors() const
+    {
+        return m_neighbors;
+    }
+
+    /**
+     * Select the vectorized or the scalar pair kernel, see LennardJones.h
+     */
+    void setVectorized(const bool vectorized)
+    {
+        m_vectorized = vectorized;
+        m_kernel = lj::kernel(vectorized, m_domains.periodic());
+    }
+
+    /**
+     * Set number of threads of the force calculation, zero for all cores
+     */
+    void setThreads(const size_t threads)
+    {
+        m_pool = std::make_unique<ode::ThreadPool>(threads);
+    }
+
+    [[nodiscard]] size_t threads() const
+    {
+        return m_pool->size();
+    }
+
+    /**
+     * Calculate the Lennard Jones forces of the particle positions
+     *
+     * Open systems of at least PARALLEL bodies are calculated by all threads of
+     * the pool, each into a force buffer of its own. The buffers take 12 bytes per
+     * body and thread, 48 MB for a million bodies on four threads.
+     */
+    void lennardJones()
+    {
+        m_forcesValid = true;
+        if (m_domains.periodic())
+        {
+            m_observables.addForces(m_domains.forces(m_particles, m_parameters, m_kernel, *m_pool));
+            return;
+        }
+
+        const size_t count{m_particles.size()};
+        const float_t* position[3]{m_particles.position(0U), m_particles.position(1U), m_particles.position(2U)};
+        float_t* force[3]{m_particles.force(0U), m_particles.force(1U), m_particles.force(2U)};
+
+        // Initalize Force
+        for (size_t k{0U}; k < 3; ++k)
+        {
+            std::fill(force[k], force[k] + count, 0.F);
+        }
+
+        // Update neighbor list
+        m_neighbors.update(count, [this](size_t i, size_t k) { return m_particles.position(k)[i]; });
+
+        if (m_pool->size() == 1U || count < PARALLEL)
+        {
+            m_observables.addForces(m_kernel(m_parameters, m_neighbors, 0U, count, position, force));
+            return;
+        }
+
+        // Each thread accumulates the forces of its pairs into its own buffer. The
+        // chunks are assigned statically, so the sums don't depend on the timing
+        const size_t threads{m_pool->size()};
+        if (m_forces.size() != threads || m_forces[0U].size() != count * 3U)
+        {
+            m_forces.assign(threads, std::vector<float_t>(count * 3U, 0.F));
+            m_sums.assign(threads, lj::Sums{});
+        }
+        m_pool->run([&](size_t thread) {
+            float_t* buffer{m_forces[thread].data()};
+            float_t* forces[3]{buffer, buffer + count, buffer + 2U * count};
+            for (size_t begin{thread * GRAIN}; begin < count; begin += threads * GRAIN)
+            {
+                m_sums[thread] += m_kernel(m_parameters, m_neighbors, begin, std::min(begin + GRAIN, count), position, forces);
+            }
+        });
+
+        // Sum the buffers block wise and clear them for the next call
+        m_pool->parallelFor(count, GRAIN, [&](size_t, size_t begin, size_t end) {
+            for (auto& forces : m_forces)
+            {
+                for (size_t k{0U}; k < 3; ++k)
+                {
+                    float_t* buffer{forces.data() + k * count};
+                    for (size_t i{begin}; i < end; ++i)
+                    {
+                        force[k][i] += buffer[i];
+                        buffer[i] = 0.F;
+                    }
+                }
+            }
+        });
+        for (auto& sums : m_sums)
+        {
+            m_observables.addForces(sums);
+            sums = lj::Sums{};
+        }
+    }
+
+    void finish()
+    {
+        if (m_checkpointInterval > 0U)
+        {
+            m_checkpoints.wait();
+            checkpoint(m_checkpointFile);
+            m_checkpoints.wait();
+        }
+        m_writer.close();
+        std::cout << "Range = [" << m_rangeX[0] << ":" << m_rangeX[1] << ", " << m_rangeY[0] << ":" << m_rangeY[1] << "]" << std::endl;
+        std::cout << "Frames = " << m_frames << std::endl;
+        for (size_t q{0U}; q < Observables::Quantities; ++q)
+        {
+            const auto quantity = static_cast<Observables::Quantity>(q);
+            const Statistics& statistics{m_observables.statistics(quantity)};
+            std::cout << Observables::name(quantity) << " = " << statistics.mean() << " +- " << std::sqrt(statistics.variance()) << std::endl;
+        }
+        if (m_writer.dropped() > 0U)
+        {
+            std::cout << "Dropped frames = " << m_writer.dropped() << std::endl;
+        }
+        if (m_checkpoints.failed() > 0U)
+        {
+            std::cout << "Failed checkpoints = " << m_checkpoints.failed() << std::endl;
+        }
+    }
+
+private:
+    /**
+     * Volume of the periodic box or the bounding box of the particles, zero for flat systems
+     */
+    [[nodiscard]] float_t boundingVolume() const
+    {
+        if (m_domains.periodic())
+        {
+            return m_parameters.box[0] * m_parameters.box[1] * m_parameters.box[2];
+        }
+        float_t volume{m_particles.size() > 0U ? 1.F : 0.F};
+        for (size_t k{0U}; k < 3U && volume > 0.F; ++k)
+        {
+            const float_t* position{m_particles.position(k)};
+            const auto range = std::minmax_element(position, position + m_particles.size());
+            volume *= *range.second - *range.first;
+        }
+        return volume;
+    }
+
+    static constexpr size_t PARALLEL{1024U}; //!< Minimum number of bodies of the parallel force calculation
+    static constexpr size_t GRAIN{256U}; //!< Bodies per scheduled chunk
+    static constexpr uint32_t CHECKPOINT{0x4d44U}; //!< Kind of the checkpoint state
+
+    Observables m_observables{};
+    std::vector<std::function<void(size_t, const Observables&)>> m_observers{};
+    size_t m_observableInterval{1U}; //!< Steps between the calls of the observers
+    float_t m_volume{0.F}; //!< Volume of the pressure
+    Particles m_particles{};
+    bool m_forcesValid{false}; //!< Forces of the particles belong to their positions
+    VelocityVerlet m_solver{};
+    NeighborList m_neighbors{};
+    lj::Parameters m_parameters{};
+    lj::Kernel m_kernel{lj::kernel(true)};
+    bool m_vectorized{true}; //!< Vectorized pair kernel
+    Domains m_domains{}; //!< Domains of the periodic box
+    std::unique_ptr<ode::ThreadPool> m_pool{std::make_unique<ode::ThreadPool>()};
+    std::vector<std::vector<float_t>> m_forces{}; //!< Force buffer of each thread, 3 * bodies * threads values
+    std::vector<lj::Sums> m_sums{}; //!< Potential energy and virial of each thread
+    FrameWriter m_writer{};
+    bool m_binary{false}; //!< Binary trajectory output
+    float_t m_timeStep{0.F}; //!< Time step of the binary trajectory
+    float_t m_time{0.F}; //!< Time of the current frame
+    size_t m_frames{0U};
+    float_t m_rangeX[2]{};
+    float_t m_rangeY[2]{};
+    ode::CheckpointWriter m_checkpoints{};
+    size_t m_checkpointInterval{0U}; //!< Steps between checkpoints
+    std::string m_checkpointFile{}; //!< Checkpoint file
+};
+}
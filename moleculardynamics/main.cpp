@@ -1,339 +1,174 @@
-
-#include "ode/VelocityVerlet.h"
+#include "Generator.h"
+#include "World.h"
 #include <atomic>
-#include <fstream>
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <thread>
-
-using Vector = ode::Vector<float_t>;
-using Function = ode::Function<float_t>;
-using VelocityVerlet = ode::VelocityVerlet<float_t>;
+#include <utility>
 
 /**
- * Body class
+ * Console class
  */
-class Body
+class Console
 {
 public:
-    Body()
-         : position(3U)
-         , velocity(3U)
-         , force(3U)
+    Console() = default;
+    
+    void operator()(std::atomic<bool>& run)
     {
+        std::string input{};
+        while (run.load())
+        {
+            std::cin >> input;
+            if (input == "exit")
+            {
+                run.store(false);
+            }
+        }
     }
-    Vector position{}; //!< Position vector
-    Vector velocity{}; //!< Velocity vector
-    Vector force{}; //!< Force vector
-    float_t mass{0.F}; //!< Mass
-};
-
-/**
- * Energy class
- */
-class Energy
-{
-public:
-    Energy() = default;
-    float_t kin{0.F}; //!< Kinetic energy
-    float_t pot{0.F}; //!< Potential energy
-    float_t total{0.F}; //!< Total energy
-    float_t temp{0.F}; //!< Temperature
 };
 
 /**
- * World class
+ * main function
  */
-class World : public Function
+int main(int argc, char** argv)
 {
-public:
-    World() = default;
-
-    void step(const float_t t, const float_t dt)
-    {
-        // Calculate new values
-        m_solver.calc(t, dt, *this);
-
-        // Calculate energy
-        kineticEnergy();
-
-        // Print results to files
-        print();
-
-        // Print energy and temperature
-        std::cout << m_energy.total << "\t" << m_energy.temp << std::endl;
-    }
-
-    void print()
+    std::string filename{};
+    size_t threads{0U};
+    bool vectorized{true};
+    std::string output{};
+    bool binary{false};
+    size_t checkpoint{0U};
+    size_t observables{100U};
+    std::string restart{};
+    std::string lattice{};
+    size_t size{0U};
+    float_t temperature{1.F};
+    uint32_t seed{1U};
+    float_t box{0.F};
+    bool periodic{false};
+    for (int i{1}; i < argc; ++i)
     {
-        for (auto& body : m_bodies)
+        const std::string argument{argv[i]};
+        if (argument == "--threads" && i + 1 < argc)
         {
-            m_plotfile << body.position[0] << "\t";
-            m_plotfile << body.position[1] << "\t";
-            m_plotfile << body.position[2] << "\t";
-
-            if (m_rangeX[0] > body.position[0])
-            {
-                m_rangeX[0] = body.position[0];
-            }
-            if (m_rangeX[1] < body.position[0])
-            {
-                m_rangeX[1] = body.position[0];
-            }
-            if (m_rangeY[0] > body.position[1])
-            {
-                m_rangeY[0]= body.position[1];
-            }
-            if (m_rangeY[1] < body.position[1])
-            {
-                m_rangeY[1] = body.position[1];
-            }
+            threads = std::stoul(argv[++i]);
         }
-        m_frames++;
-        m_plotfile << std::endl;
-    }
-
-    bool initialize(const std::string& filename)
-    {
-        std::ifstream file(filename, std::ios::in);
-        if (file.good())
+        else if (argument == "--kernel" && i + 1 < argc)
         {
-            uint32_t count{0U};
-            file >> count;
-            std::cout << "Number of bodies = " << count << std::endl;
-            m_bodies.resize(count);
-            for (uint32_t i{0U}; i < count; ++i)
-            {
-                file >> m_bodies[i].position[0];
-                file >> m_bodies[i].position[1];
-                file >> m_bodies[i].position[2];
-                file >> m_bodies[i].mass;
-            }
-            m_plotfile.open("Moleculesystem.dat", std::ios::out | std::ios::trunc);
-            return true;
+            vectorized = std::string{argv[++i]} != "scalar";
         }
-        std::cout << "Invalid file " << filename.c_str() << std::endl;
-        return false;
-    }
-
-    void finish()
-    {
-        m_plotfile.close();
-        std::cout << "Range = [" << m_rangeX[0] << ":" << m_rangeX[1] << ", " << m_rangeY[0] << ":" << m_rangeY[1] << "]" << std::endl;
-        std::cout << "Frames = " << m_frames << std::endl;
-    }
-
-protected:
-    Vector derive(float_t x, Vector& y) final
-    {
-        const size_t size = m_bodies.size() * 9U;
-        Vector dydx = y;
-
-        // Calculate Lennard Jones Potential
-        lennardJones(y);
-
-        // Calculate position / velocity
-        std::vector<Body>::iterator it = m_bodies.begin();
-        for (uint32_t a{0U}; a < size; a += 9)
+        else if (argument == "--format" && i + 1 < argc)
         {
-            float_t mass{it->mass};
-            it++;
-
-            for (uint32_t k{0U}; k < 3; ++k)
-            {
-                // R += dR * dt + (.5 / m) * F * dt^2
-                y[a + k] += y[a + k + 3] * x + .5F / mass * y[a + k + 6] * std::pow(x, 2.F);
-
-                // dR = dR + (.5 / m) * F * dt
-                dydx[a + k + 3] = y[a + k + 3] + .5F / mass * y[a + k + 6] * x;
-            }
+            binary = std::string{argv[++i]} == "binary";
         }
-
-        return dydx;
-    }
-
-    Vector derive2(float_t x, Vector& y, Vector& dy) final
-    {
-        const size_t size = m_bodies.size() * 9U;
-        Vector dydx = y;
-
-        // Calculate Lennard Jones Potential
-        lennardJones(dydx);
-
-        // Calculate velocity
-        std::vector<Body>::iterator it = m_bodies.begin();
-        for (uint32_t a{0U}; a < size; a += 9)
+        else if (argument == "--checkpoint" && i + 1 < argc)
         {
-			float_t mass{it->mass};
-            it++;
-
-            for (uint32_t k{0U}; k < 3; ++k)
-            {
-                // dR = dR + (.5 / m) * F * dt
-                dydx[a + k + 3] = dy[a + k + 3] + .5F / mass * dydx[a + k + 6] * x;
-            }
+            checkpoint = std::stoul(argv[++i]);
         }
-
-        return dydx;
-    }
-
-    Vector getParams() const final
-    {
-        Vector y(m_bodies.size() * 9);
-
-        uint32_t i{0U};
-        for (auto& body : m_bodies)
+        else if (argument == "--observables" && i + 1 < argc)
         {
-            // Position
-            y[i++] = body.position[0];
-            y[i++] = body.position[1];
-            y[i++] = body.position[2];
-
-            // Velocity
-            y[i++] = body.velocity[0];
-            y[i++] = body.velocity[1];
-            y[i++] = body.velocity[2];
-
-            // Force
-            y[i++] = body.force[0];
-            y[i++] = body.force[1];
-            y[i++] = body.force[2];
+            observables = std::stoul(argv[++i]);
         }
-        return y;
-    }
-
-    void setParams(const Vector& y) final
-    {
-        if (y.size() == m_bodies.size() * 9)
+        else if (argument == "--restart" && i + 1 < argc)
         {
-            uint32_t i{0U};
-            for (auto& body : m_bodies)
-            {
-                // Position
-                body.position[0] = y[i++];
-                body.position[1] = y[i++];
-                body.position[2] = y[i++];
-
-                // Velocity
-                body.velocity[0] = y[i++];
-                body.velocity[1] = y[i++];
-                body.velocity[2] = y[i++];
-
-                // Force
-                body.force[0] = y[i++];
-                body.force[1] = y[i++];
-                body.force[2] = y[i++];
-            }
+            restart = argv[++i];
         }
-    }
-    
-    void lennardJones(Vector& y)
-    {
-        const size_t size = m_bodies.size() * 9U;
-        Vector dr(size);
-        float_t pot = 0.F;
-        float_t rho = 0.F;
-
-        // Initalize Force
-        for (size_t a{0U}; a < size; a += 9)
+        else if ((argument == "--lattice" && i + 2 < argc) || (argument == "--gas" && i + 1 < argc))
         {
-            for (size_t k{0U}; k < 3; ++k)
-            {
-                y[a + k + 6] = 0.F;
-            }
+            lattice = argument == "--gas" ? "gas" : argv[++i];
+            size = std::stoul(argv[++i]);
         }
-
-        // Calculate Lennard Jones Potential
-        static constexpr float_t SIGMA_2{40.F * 40.F};
-        static constexpr float_t EPSILON{20.F};
-        for (size_t a{0U}; a < size; a += 9)
+        else if (argument == "--box" && i + 1 < argc)
         {
-            for (size_t b{a + 9U}; b < size; b += 9)
-            {
-                for (size_t k{0U}; k < 3; ++k)
-                {
-                    dr[k] = y[a + k] - y[b + k];
-                }
-                rho = SIGMA_2 / (std::pow(dr[0], 2.F) + std::pow(dr[1], 2.F) + std::pow(dr[2], 2.F));
-                pot = 1.F * (2.F * std::pow(rho, 7.F) - std::pow(rho, 4.F));
-                for (size_t k{0U}; k < 3; ++k)
-                {
-                    y[a + k + 6] += 24.F * EPSILON / SIGMA_2 * pot * dr[k];
-                    y[b + k + 6] -= 24.F * EPSILON / SIGMA_2 * pot * dr[k];
-                }
-                m_energy.pot += 4.F * EPSILON * (std::pow(rho, 6.F) - std::pow(rho, 3.F));
-            }
+            box = std::stof(argv[++i]);
+            periodic = true;
         }
-    }
-
-    void kineticEnergy()
-    {
-        static constexpr float_t KB{1.F};
-        m_energy.kin = 0.F;
-
-        for (auto& body : m_bodies)
+        else if (argument == "--periodic")
         {
-            // Ekin = 1/2 * m * v^2
-            for (uint32_t k{0U}; k < 3; ++k)
-            {
-                m_energy.kin += .5F * body.mass * (std::pow(body.velocity[k], 2.F));
-            }
+            periodic = true;
+        }
+        else if (argument == "--temperature" && i + 1 < argc)
+        {
+            temperature = std::stof(argv[++i]);
+        }
+        else if (argument == "--seed" && i + 1 < argc)
+        {
+            seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            filename = argument;
         }
-
-        const float_t size = static_cast<float_t>(m_bodies.size()) * 9.F;
-        m_energy.total = m_energy.kin + m_energy.pot;
-        m_energy.temp = m_energy.kin * 2.F / (3.F * size * KB);
     }
-
-private:
-    Energy m_energy{};
-    std::vector<Body> m_bodies{};
-    VelocityVerlet m_solver{};
-    std::ofstream m_plotfile{};
-    size_t m_frames{0U};
-    float_t m_rangeX[2];
-    float_t m_rangeY[2];
-};
-
-/**
- * Console class
- */
-class Console
-{
-public:
-    Console() = default;
-    
-    void operator()(std::atomic<bool>& run)
+    if (!filename.empty() || !restart.empty() || size > 0U)
     {
-        std::string input{};
-        while (run.load())
+        md::World world{};
+        world.setThreads(threads);
+        world.setVectorized(vectorized);
+        world.setOutputPolicy(md::FrameWriter::toPolicy(output));
+        static constexpr float_t dt{0.0001F};
+        world.setBinaryOutput(binary, dt);
+        world.setCheckpoint(checkpoint, "Moleculesystem.chk");
+        world.setObservableInterval(observables);
+        world.addObserver([](size_t frame, const md::Observables& observables) {
+            std::cout << frame << "\t" << observables.value(md::Observables::Total) << "\t" << observables.value(md::Observables::Temperature) << "\t" << observables.value(md::Observables::Pressure) << '\n';
+        });
+        bool ready{!restart.empty() && world.restore(restart)};
+        if (ready)
         {
-            std::cin >> input;
-            if (input == "exit")
+            // The trajectory is written anew from the checkpoint on
+            ready = world.openOutput();
+        }
+        else if (restart.empty() && size > 0U)
+        {
+            // Nearest neighbors at the minimum of the potential, the gas has a tenth of their density
+            const float_t spacing{std::pow(2.F, 1.F / 6.F) * std::sqrt(md::lj::Parameters{}.sigma2)};
+            md::Particles particles{};
+            float_t volume{0.F};
+            if (lattice == "gas")
             {
-                run.store(false);
+                // A periodic gas fills the box, its minimum distance holds across the boundaries
+                const float_t side{periodic && box > 0.F ? box : spacing * std::cbrt(10.F * static_cast<float_t>(size))};
+                volume = md::generate::gas(particles, size, side, .9F * spacing, 1.F, seed, periodic);
             }
+            else
+            {
+                volume = md::generate::lattice(particles, lattice == "cubic" ? md::generate::Lattice::Cubic : md::generate::Lattice::Fcc, size, spacing, 1.F);
+            }
+            md::generate::maxwellBoltzmann(particles, temperature, seed);
+            std::cout << "Number of bodies = " << particles.size() << std::endl;
+            world.initialize(std::move(particles));
+            world.setVolume(volume);
+            box = box > 0.F ? box : std::cbrt(volume);
+            ready = world.openOutput();
         }
-    }
-};
-
-/**
- * main function
- */
-int main(int argc, char** argv)
-{
-    std::string filename{};
-    if (argc >= 2)
-    {
-        World world{};
-        if (world.initialize(argv[1]))
+        else if (restart.empty())
+        {
+            ready = world.initialize(filename);
+        }
+        const float_t lengths[3]{box, box, box};
+        if (ready && restart.empty() && periodic && (box <= 0.F || !world.setBox(lengths)))
+        {
+            std::cout << "Invalid box " << box << std::endl;
+            ready = false;
+        }
+        if (ready)
         {
             Console console{};
             std::atomic<bool> run(true);
             std::thread console_t(console, std::ref(run));
+
+            float_t t{world.time()};
             while (run.load())
             {
-                world.step(0.0001F, 0.F);
+                world.step(t, dt);
+                t += dt;
             }
             world.finish();
             run.store(false);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ode
+{
+/**
+ * @brief Butcher tableaus of explicit Runge Kutta methods
+ *
+ * A tableau provides the number of stages, the order and the coefficients
+ * `A` (stage weights, strictly lower triangular), `B` (solution weights) and
+ * `C` (stage nodes).
+ */
+namespace tableau
+{
+/**
+ * @brief Forward Euler
+ */
+struct Euler
+{
+    static constexpr size_t STAGES{1U};
+    static constexpr size_t ORDER{1U};
+    static constexpr double A[STAGES][STAGES]{{0.}};
+    static constexpr double B[STAGES]{1.};
+    static constexpr double C[STAGES]{0.};
+};
+
+/**
+ * @brief Heun (explicit trapezoidal rule)
+ */
+struct Heun
+{
+    static constexpr size_t STAGES{2U};
+    static constexpr size_t ORDER{2U};
+    static constexpr double A[STAGES][STAGES]{{0., 0.}, {1., 0.}};
+    static constexpr double B[STAGES]{1. / 2., 1. / 2.};
+    static constexpr double C[STAGES]{0., 1.};
+};
+
+/**
+ * @brief Explicit midpoint
+ */
+struct MidPoint
+{
+    static constexpr size_t STAGES{2U};
+    static constexpr size_t ORDER{2U};
+    static constexpr double A[STAGES][STAGES]{{0., 0.}, {1. / 2., 0.}};
+    static constexpr double B[STAGES]{0., 1.};
+    static constexpr double C[STAGES]{0., 1. / 2.};
+};
+
+/**
+ * @brief Ralston, 2nd order with minimal truncation error
+ */
+struct Ralston
+{
+    static constexpr size_t STAGES{2U};
+    static constexpr size_t ORDER{2U};
+    static constexpr double A[STAGES][STAGES]{{0., 0.}, {2. / 3., 0.}};
+    static constexpr double B[STAGES]{1. / 4., 3. / 4.};
+    static constexpr double C[STAGES]{0., 2. / 3.};
+};
+
+/**
+ * @brief Bogacki Shampine, 3rd order solution without the embedded 2nd order stage
+ */
+struct BogackiShampine
+{
+    static constexpr size_t STAGES{3U};
+    static constexpr size_t ORDER{3U};
+    static constexpr double A[STAGES][STAGES]{{0., 0., 0.}, {1. / 2., 0., 0.}, {0., 3. / 4., 0.}};
+    static constexpr double B[STAGES]{2. / 9., 1. / 3., 4. / 9.};
+    static constexpr double C[STAGES]{0., 1. / 2., 3. / 4.};
+};
+
+/**
+ * @brief Classical 4th order Runge Kutta
+ */
+struct RungeKutta
+{
+    static constexpr size_t STAGES{4U};
+    static constexpr size_t ORDER{4U};
+    static constexpr double A[STAGES][STAGES]{{0., 0., 0., 0.}, {1. / 2., 0., 0., 0.}, {0., 1. / 2., 0., 0.}, {0., 0., 1., 0.}};
+    static constexpr double B[STAGES]{1. / 6., 1. / 3., 1. / 3., 1. / 6.};
+    static constexpr double C[STAGES]{0., 1. / 2., 1. / 2., 1.};
+};
+
+/**
+ * @brief Runge Kutta 3/8 rule
+ */
+struct RungeKutta38
+{
+    static constexpr size_t STAGES{4U};
+    static constexpr size_t ORDER{4U};
+    static constexpr double A[STAGES][STAGES]{{0., 0., 0., 0.}, {1. / 3., 0., 0., 0.}, {-1. / 3., 1., 0., 0.}, {1., -1., 1., 0.}};
+    static constexpr double B[STAGES]{1. / 8., 3. / 8., 3. / 8., 1. / 8.};
+    static constexpr double C[STAGES]{0., 1. / 3., 2. / 3., 1.};
+};
+}
+}
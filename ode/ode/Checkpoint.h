@@ -0,0 +1,352 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ode
+{
+/**
+ * @brief Archive class
+ *
+ * Binary buffer of trivially copyable values, written and read in the same
+ * order. A file starts with a signature and the kind of the saved state.
+ */
+class Archive
+{
+public:
+    Archive() = default;
+
+    /**
+     * Start an archive of the given kind of state
+     */
+    void begin(const uint32_t kind)
+    {
+        m_data.clear();
+        m_position = 0U;
+        write(SIGNATURE, sizeof(SIGNATURE));
+        write(kind);
+    }
+
+    /**
+     * Append values
+     */
+    template<typename T>
+    void write(const T* values, const size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Archive values must be trivially copyable");
+        const size_t size{count * sizeof(T)};
+        const size_t offset{m_data.size()};
+        m_data.resize(offset + size);
+        if (size > 0U)
+        {
+            std::memcpy(m_data.data() + offset, values, size);
+        }
+    }
+
+    template<typename T>
+    void write(const T& value)
+    {
+        write(&value, 1U);
+    }
+
+    /**
+     * Append the size and the values of a vector
+     */
+    template<typename T>
+    void write(const std::vector<T>& values)
+    {
+        write(static_cast<uint64_t>(values.size()));
+        write(values.data(), values.size());
+    }
+
+    void write(const std::string& text)
+    {
+        write(static_cast<uint64_t>(text.size()));
+        write(text.data(), text.size());
+    }
+
+    /**
+     * Read values
+     * @return false if the archive holds less values
+     */
+    template<typename T>
+    bool read(T* values, const size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Archive values must be trivially copyable");
+        const size_t size{count * sizeof(T)};
+        if (m_position + size > m_data.size())
+        {
+            m_position = m_data.size();
+            return false;
+        }
+        if (size > 0U)
+        {
+            std::memcpy(values, m_data.data() + m_position, size);
+        }
+        m_position += size;
+        return true;
+    }
+
+    template<typename T>
+    bool read(T& value)
+    {
+        return read(&value, 1U);
+    }
+
+    template<typename T>
+    bool read(std::vector<T>& values)
+    {
+        uint64_t size{0U};
+        if (!read(size) || size > (m_data.size() - m_position) / sizeof(T))
+        {
+            return false;
+        }
+        values.resize(size);
+        return read(values.data(), values.size());
+    }
+
+    bool read(std::string& text)
+    {
+        uint64_t size{0U};
+        if (!read(size) || size > m_data.size() - m_position)
+        {
+            return false;
+        }
+        text.resize(size);
+        return read(text.data(), text.size());
+    }
+
+    /**
+     * Number of bytes not read yet
+     */
+    [[nodiscard]] size_t remaining() const
+    {
+        return m_data.size() - m_position;
+    }
+
+    /**
+     * Write the archive to a file, replacing it only once complete
+     */
+    bool save(const std::string& filename) const
+    {
+        const std::string temporary{filename + ".tmp"};
+        {
+            std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+            file.close();
+            if (!file.good())
+            {
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+#ifdef _WIN32
+        // rename doesn't replace an existing file on Windows
+        std::remove(filename.c_str());
+#endif
+        return std::rename(temporary.c_str(), filename.c_str()) == 0;
+    }
+
+    /**
+     * Read an archive of the given kind of state from a file
+     * @return false if the file can't be read or holds another kind of state
+     */
+    bool load(const std::string& filename, const uint32_t kind)
+    {
+        std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.good())
+        {
+            return false;
+        }
+        m_data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+        m_position = 0U;
+
+        char signature[sizeof(SIGNATURE)]{};
+        uint32_t stored{0U};
+        return file.good() && read(signature, sizeof(signature)) && std::memcmp(signature, SIGNATURE, sizeof(SIGNATURE)) == 0 && read(stored) && stored == kind;
+    }
+
+private:
+    //! File signature including the format version
+    static constexpr char SIGNATURE[8]{'O', 'D', 'E', 'C', 'H', 'K', '\0', '\1'};
+
+    std::vector<char> m_data{};
+    size_t m_position{0U}; //!< Read position
+};
+
+/**
+ * @brief CheckpointWriter class
+ *
+ * Saves archives from a background thread. The caller only copies the state
+ * into one of two archives, the file is written while the simulation goes on.
+ * A checkpoint is skipped if both archives are still in use.
+ */
+class CheckpointWriter
+{
+public:
+    CheckpointWriter() = default;
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    ~CheckpointWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_changed.notify_all();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    /**
+     * Save a checkpoint
+     * @param filename   File name
+     * @param kind       Kind of the saved state
+     * @param serialize  Writes the state into the given archive as serialize(archive)
+     * @return false if the checkpoint was skipped
+     */
+    template<typename F>
+    bool save(const std::string& filename, const uint32_t kind, F&& serialize)
+    {
+        Slot* slot{nullptr};
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto& candidate : m_slots)
+            {
+                if (candidate.state == State::Free)
+                {
+                    slot = &candidate;
+                    slot->state = State::Filling;
+                    break;
+                }
+            }
+        }
+        if (slot == nullptr)
+        {
+            ++m_skipped;
+            return false;
+        }
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread([this]() { work(); });
+        }
+
+        slot->archive.begin(kind);
+        serialize(slot->archive);
+        slot->filename = filename;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            slot->state = State::Queued;
+            slot->sequence = ++m_sequence;
+        }
+        m_changed.notify_all();
+        return true;
+    }
+
+    /**
+     * Wait until all queued checkpoints are written
+     */
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_changed.wait(lock, [this]() { return m_slots[0].state == State::Free && m_slots[1].state == State::Free; });
+    }
+
+    /**
+     * Number of skipped checkpoints
+     */
+    [[nodiscard]] size_t skipped() const
+    {
+        return m_skipped;
+    }
+
+    /**
+     * Number of checkpoints which couldn't be written
+     */
+    [[nodiscard]] size_t failed() const
+    {
+        return m_failed;
+    }
+
+private:
+    enum class State
+    {
+        Free,
+        Filling,
+        Queued,
+        Writing
+    };
+
+    struct Slot
+    {
+        Archive archive{};
+        std::string filename{};
+        State state{State::Free};
+        size_t sequence{0U}; //!< Order of the checkpoints
+    };
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        for (;;)
+        {
+            m_changed.wait(lock, [this]() { return m_stop || next() != nullptr; });
+            Slot* slot{next()};
+            if (slot == nullptr)
+            {
+                return;
+            }
+            slot->state = State::Writing;
+            lock.unlock();
+            if (!slot->archive.save(slot->filename))
+            {
+                ++m_failed;
+            }
+            lock.lock();
+            slot->state = State::Free;
+            m_changed.notify_all();
+        }
+    }
+
+    /**
+     * Return the oldest queued slot
+     */
+    Slot* next()
+    {
+        Slot* slot{nullptr};
+        for (auto& candidate : m_slots)
+        {
+            if (candidate.state == State::Queued && (slot == nullptr || candidate.sequence < slot->sequence))
+            {
+                slot = &candidate;
+            }
+        }
+        return slot;
+    }
+
+    Slot m_slots[2]{};
+    std::mutex m_mutex{};
+    std::condition_variable m_changed{}; //!< Signals queued and written checkpoints
+    std::thread m_thread{};
+    size_t m_sequence{0U};
+    size_t m_skipped{0U};
+    std::atomic<size_t> m_failed{0U}; //!< Incremented by the writer thread
+    bool m_stop{false};
+};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Vector.h"
+#include <algorithm>
+#include <utility>
+
+namespace ode
+{
+/**
+ * @brief DenseOutput class
+ *
+ * Cubic Hermite interpolation of the parameters between the start and the end
+ * of a step from the parameters and derivatives at both ends. The error is of
+ * 4th order in the step size.
+ */
+template<typename T, size_t N = Dynamic, typename Enable = void>
+class DenseOutput;
+
+template<typename T, size_t N>
+class DenseOutput<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    DenseOutput() = default;
+
+    /**
+     * Set start of the step
+     * @param x      Variable
+     * @param y      Parameters
+     * @param dydx   Derivative
+     */
+    void begin(T x, const Vector<T, N>& y, const Vector<T, N>& dydx)
+    {
+        m_x0 = x;
+        m_y0 = y;
+        m_f0 = dydx;
+    }
+
+    /**
+     * Set end of the step
+     * @param x      Variable
+     * @param y      Parameters
+     * @param dydx   Derivative
+     */
+    void end(T x, const Vector<T, N>& y, const Vector<T, N>& dydx)
+    {
+        m_x1 = x;
+        m_y1 = y;
+        m_f1 = dydx;
+    }
+
+    /**
+     * Continue with the next step, its start is the end of the current step
+     */
+    void advance()
+    {
+        m_x0 = m_x1;
+        std::swap(m_y0, m_y1);
+        std::swap(m_f0, m_f1);
+    }
+
+    [[nodiscard]] T start() const
+    {
+        return m_x0;
+    }
+
+    [[nodiscard]] T stop() const
+    {
+        return m_x1;
+    }
+
+    /**
+     * Interpolate parameters
+     * @param x      Variable within [start, stop]
+     * @param y      Interpolated parameters
+     */
+    void interpolate(T x, Vector<T, N>& y) const
+    {
+        const T dx{m_x1 - m_x0};
+        const T theta{dx > T{0} ? std::clamp((x - m_x0) / dx, T{0}, T{1}) : T{0}};
+        const T theta2{theta * theta};
+        const T theta3{theta2 * theta};
+        const T h00{T{2} * theta3 - T{3} * theta2 + T{1}};
+        const T h10{theta3 - T{2} * theta2 + theta};
+        const T h01{T{-2} * theta3 + T{3} * theta2};
+        const T h11{theta3 - theta2};
+        y = m_y0 * h00 + m_f0 * (h10 * dx) + m_y1 * h01 + m_f1 * (h11 * dx);
+    }
+
+private:
+    T m_x0{0}; //!< Start variable
+    T m_x1{0}; //!< End variable
+    Vector<T, N> m_y0{}; //!< Start parameters
+    Vector<T, N> m_y1{}; //!< End parameters
+    Vector<T, N> m_f0{}; //!< Start derivative
+    Vector<T, N> m_f1{}; //!< End derivative
+};
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include "Solver.h"
+#include "StaticFunction.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace ode
+{
+/**
+ * @brief DormandPrince class
+ *
+ * Embedded Runge Kutta 5(4) pair with error control. `calc` takes a single
+ * step of size dx, `calcRange` adapts the step size with a PI controller and
+ * reuses the last stage of an accepted step as the first stage of the next
+ * one (FSAL).
+ */
+template<typename T, size_t N = Dynamic, typename Enable = void>
+class DormandPrince;
+
+template<typename T, size_t N>
+class DormandPrince<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type> : public Solver<T, N>
+{
+public:
+    /**
+     * @brief Step statistics
+     */
+    struct Statistics
+    {
+        size_t accepted{0U}; //!< Steps passing the error test
+        size_t rejected{0U}; //!< Steps failing the error test, repeated by calcRange, taken anyway by calc
+        size_t evaluations{0U}; //!< Derivative evaluations
+        bool underflow{false}; //!< calcRange stopped before the end, because the step fell below the resolution of the variable or the error wasn't finite
+    };
+
+    DormandPrince() = default;
+
+    /**
+     * Set error tolerances of the adaptive step size control
+     * @param absolute   Absolute tolerance
+     * @param relative   Relative tolerance
+     */
+    void setTolerance(const T absolute, const T relative)
+    {
+        m_absolute = absolute;
+        m_relative = relative;
+    }
+
+    /**
+     * Return the step statistics since construction or the last reset
+     */
+    [[nodiscard]] const Statistics& statistics() const
+    {
+        return m_statistics;
+    }
+
+    /**
+     * Reset the step statistics
+     */
+    void reset()
+    {
+        m_statistics = Statistics{};
+    }
+
+    using Solver<T, N>::calc;
+
+    void calc(T x, T dx, Function<T, N>& function, Workspace<T, N>& workspace) final
+    {
+        step(x, dx, function, workspace);
+    }
+
+    /**
+     * Calculate integration step without virtual dispatch
+     *
+     * The step of size dx is taken even if its error exceeds the tolerances,
+     * it is counted as accepted or rejected by the error test.
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Ode function, see StaticFunction.h
+     * @param workspace  Reusable buffers, the calculated parameters are stored in workspace.dy
+     */
+    template<typename F>
+    void step(T x, T dx, F& function, Workspace<T, N>& workspace)
+    {
+        ode::getParams(function, workspace.y);
+        workspace.resize(7U, workspace.y.size());
+
+        const T error{attempt(x, dx, function, workspace, false)};
+        function.setParams(workspace.dy);
+        if (error <= T{1})
+        {
+            m_statistics.accepted++;
+        }
+        else
+        {
+            m_statistics.rejected++;
+        }
+    }
+
+    /**
+     * Integrate with adaptive step size
+     * @param x0         Start variable
+     * @param y0         Start parameters
+     * @param x          End variable
+     * @param dx         Initial variable step
+     * @param function   Ode function
+     * @return calculated parameters, at the variable reached if statistics().underflow is set
+     */
+    Vector<T, N> calcRange(T x0, const Vector<T, N>& y0, T x, T dx, Function<T, N>& function) override
+    {
+        return stepRange(x0, y0, x, dx, function);
+    }
+
+    /**
+     * Integrate with adaptive step size without virtual dispatch
+     * @param x0         Start variable
+     * @param y0         Start parameters
+     * @param x          End variable
+     * @param dx         Initial variable step
+     * @param function   Ode function, see StaticFunction.h
+     * @return calculated parameters, at the variable reached if statistics().underflow is set
+     */
+    template<typename F>
+    Vector<T, N> stepRange(T x0, const Vector<T, N>& y0, T x, T dx, F& function)
+    {
+        return stepRange(x0, y0, x, dx, function, T{0}, []([[maybe_unused]] T xk, [[maybe_unused]] const Vector<T, N>& yk) {});
+    }
+
+    /**
+     * Integrate with adaptive step size and dense output
+     *
+     * The parameters of the function are sampled at x0 + k * interval by the
+     * continuous extension of the method, which needs no further derivative
+     * evaluations. The step size is independent of the sample interval.
+     * @param x0         Start variable
+     * @param y0         Start parameters
+     * @param x          End variable
+     * @param dx         Initial variable step
+     * @param function   Ode function, see StaticFunction.h
+     * @param interval   Sample interval, no samples if zero
+     * @param output     Called with each sample as output(xk, yk)
+     * @return calculated parameters, at the variable reached if statistics().underflow is set
+     */
+    template<typename F, typename O>
+    Vector<T, N> stepRange(T x0, const Vector<T, N>& y0, T x, T dx, F& function, T interval, O&& output)
+    {
+        static constexpr T SAFETY{0.9};
+        static constexpr T FACMIN{0.2};
+        static constexpr T FACMAX{10};
+        static constexpr T BETA{0.04};
+        static constexpr T EXPONENT{T{0.2} - BETA * T{0.75}};
+
+        Vector<T, N> y{y0};
+        Workspace<T, N> workspace{};
+        T t{x0};
+        T h{dx};
+        T errorOld{1e-4};
+        bool fsal{false};
+        bool rejected{false};
+        size_t samples{0U};
+        T next{x0};
+        while (t < x)
+        {
+            if (t + h > x)
+            {
+                h = x - t;
+            }
+            if (h <= std::abs(t) * std::numeric_limits<T>::epsilon())
+            {
+                // Reported in all builds, the caller can't reach x with this tolerance
+                m_statistics.underflow = true;
+                break;
+            }
+
+            ode::getParams(function, workspace.y);
+            workspace.resize(7U, workspace.y.size());
+            const T error{attempt(t, h, function, workspace, fsal)};
+            const T factor{std::pow(error, EXPONENT)};
+            if (error <= T{1})
+            {
+                // Samples within the step
+                const T end{t + h};
+                const T tolerance{T{64} * std::numeric_limits<T>::epsilon() * std::max(std::abs(end), T{1})};
+                while (interval > T{0} && next <= end + tolerance)
+                {
+                    interpolate(std::min((next - t) / h, T{1}), h, workspace);
+                    output(next, static_cast<const Vector<T, N>&>(workspace.dydx));
+                    next = x0 + static_cast<T>(++samples) * interval;
+                }
+
+                function.setParams(workspace.dy);
+                y += workspace.dy;
+                t += h;
+                m_statistics.accepted++;
+
+                // First same as last
+                std::swap(workspace.k[0U], workspace.k[6U]);
+                fsal = true;
+
+                const T scale{std::clamp(factor / std::pow(errorOld, BETA) / SAFETY, T{1} / FACMAX, T{1} / FACMIN)};
+                h = rejected ? std::min(h, h / scale) : h / scale;
+                errorOld = std::max(error, T{1e-4});
+                rejected = false;
+            }
+            else
+            {
+                m_statistics.rejected++;
+                fsal = true;
+                // A NaN error, e.g. from an overflowing stage, shrinks the step until it underflows
+                h = std::isfinite(error) ? h / std::min(factor / SAFETY, T{1} / FACMIN) : h * FACMIN;
+                rejected = true;
+            }
+        }
+        return y;
+    }
+
+private:
+    /**
+     * Evaluate the continuous extension of the last step at x + theta * dx into workspace.dydx
+     */
+    void interpolate(const T theta, const T dx, Workspace<T, N>& workspace)
+    {
+        static constexpr T D1{T{-12715105075.} / T{11282082432.}};
+        static constexpr T D3{T{87487479700.} / T{32700410799.}};
+        static constexpr T D4{T{-10690763975.} / T{1880347072.}};
+        static constexpr T D5{T{701980252875.} / T{199316789632.}};
+        static constexpr T D6{T{-1453857185.} / T{822651844.}};
+        static constexpr T D7{T{69997945.} / T{29380423.}};
+
+        const Vector<T, N>& y{workspace.y};
+        const Vector<T, N>& dy{workspace.dy};
+        const auto& k = workspace.k;
+        const T theta1{T{1} - theta};
+        for (size_t i{0U}; i < y.size(); ++i)
+        {
+            const T b{dx * k[0U][i] - dy[i]};
+            const T c{dy[i] - dx * k[6U][i] - b};
+            const T d{dx * (D1 * k[0U][i] + D3 * k[2U][i] + D4 * k[3U][i] + D5 * k[4U][i] + D6 * k[5U][i] + D7 * k[6U][i])};
+            workspace.dydx[i] = y[i] + theta * (dy[i] + theta1 * (b + theta * (c + theta1 * d)));
+        }
+    }
+
+    /**
+     * Calculate a step of size dx into workspace.dy
+     * @return scaled error norm, the step is acceptable if less or equal 1
+     */
+    template<typename F>
+    T attempt(T x, T dx, F& function, Workspace<T, N>& workspace, const bool fsal)
+    {
+        static constexpr T C2{T{1} / T{5}};
+        static constexpr T C3{T{3} / T{10}};
+        static constexpr T C4{T{4} / T{5}};
+        static constexpr T C5{T{8} / T{9}};
+        static constexpr T A21{T{1} / T{5}};
+        static constexpr T A31{T{3} / T{40}};
+        static constexpr T A32{T{9} / T{40}};
+        static constexpr T A41{T{44} / T{45}};
+        static constexpr T A42{T{-56} / T{15}};
+        static constexpr T A43{T{32} / T{9}};
+        static constexpr T A51{T{19372} / T{6561}};
+        static constexpr T A52{T{-25360} / T{2187}};
+        static constexpr T A53{T{64448} / T{6561}};
+        static constexpr T A54{T{-212} / T{729}};
+        static constexpr T A61{T{9017} / T{3168}};
+        static constexpr T A62{T{-355} / T{33}};
+        static constexpr T A63{T{46732} / T{5247}};
+        static constexpr T A64{T{49} / T{176}};
+        static constexpr T A65{T{-5103} / T{18656}};
+        static constexpr T B1{T{35} / T{384}};
+        static constexpr T B3{T{500} / T{1113}};
+        static constexpr T B4{T{125} / T{192}};
+        static constexpr T B5{T{-2187} / T{6784}};
+        static constexpr T B6{T{11} / T{84}};
+        static constexpr T E1{T{71} / T{57600}};
+        static constexpr T E3{T{-71} / T{16695}};
+        static constexpr T E4{T{71} / T{1920}};
+        static constexpr T E5{T{-17253} / T{339200}};
+        static constexpr T E6{T{22} / T{525}};
+        static constexpr T E7{T{-1} / T{40}};
+
+        Vector<T, N>& y{workspace.y};
+        Vector<T, N>& yx{workspace.yx};
+        Vector<T, N>& dy{workspace.dy};
+        Vector<T, N>& k1{workspace.k[0U]};
+        Vector<T, N>& k2{workspace.k[1U]};
+        Vector<T, N>& k3{workspace.k[2U]};
+        Vector<T, N>& k4{workspace.k[3U]};
+        Vector<T, N>& k5{workspace.k[4U]};
+        Vector<T, N>& k6{workspace.k[5U]};
+        Vector<T, N>& k7{workspace.k[6U]};
+
+        if (!fsal)
+        {
+            ode::derive(function, x, y, k1);
+            m_statistics.evaluations++;
+        }
+
+        yx = y + k1 * (A21 * dx);
+        ode::derive(function, x + C2 * dx, yx, k2);
+
+        yx = y + (k1 * A31 + k2 * A32) * dx;
+        ode::derive(function, x + C3 * dx, yx, k3);
+
+        yx = y + (k1 * A41 + k2 * A42 + k3 * A43) * dx;
+        ode::derive(function, x + C4 * dx, yx, k4);
+
+        yx = y + (k1 * A51 + k2 * A52 + k3 * A53 + k4 * A54) * dx;
+        ode::derive(function, x + C5 * dx, yx, k5);
+
+        yx = y + (k1 * A61 + k2 * A62 + k3 * A63 + k4 * A64 + k5 * A65) * dx;
+        ode::derive(function, x + dx, yx, k6);
+
+        dy = (k1 * B1 + k3 * B3 + k4 * B4 + k5 * B5 + k6 * B6) * dx;
+        yx = y + dy;
+        ode::derive(function, x + dx, yx, k7);
+        m_statistics.evaluations += 6U;
+
+        // Scaled root mean square of the embedded error estimate
+        T sum{0};
+        for (size_t i{0U}; i < y.size(); ++i)
+        {
+            const T error{(k1[i] * E1 + k3[i] * E3 + k4[i] * E4 + k5[i] * E5 + k6[i] * E6 + k7[i] * E7) * dx};
+            const T scale{m_absolute + m_relative * std::max(std::abs(y[i]), std::abs(yx[i]))};
+            sum += (error / scale) * (error / scale);
+        }
+        return y.empty() ? T{0} : std::sqrt(sum / static_cast<T>(y.size()));
+    }
+
+    T m_absolute{1e-6}; //!< Absolute tolerance
+    T m_relative{1e-6}; //!< Relative tolerance
+    Statistics m_statistics{};
+};
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Vector.h"
+
+namespace ode
+{
+/**
+ * @brief Ensemble class
+ *
+ * State of many instances of the same ODE system in structure of arrays
+ * layout. The values of one component of all instances (lanes) are stored
+ * contiguously, so a component can be processed across all lanes by a single
+ * vectorizable loop.
+ */
+template<typename T, typename Enable = void>
+class Ensemble;
+
+template<typename T>
+class Ensemble<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    //! Lanes of a component are padded to a multiple of a cache line
+    static constexpr size_t PADDING{64U / sizeof(T)};
+
+    Ensemble() = default;
+
+    /**
+     * Create ensemble
+     * @param dimension  Number of components of a single instance
+     * @param count      Number of instances
+     */
+    Ensemble(const size_t dimension, const size_t count)
+    {
+        resize(dimension, count);
+    }
+
+    /**
+     * Resize ensemble, values are reset to zero
+     * @param dimension  Number of components of a single instance
+     * @param count      Number of instances
+     */
+    void resize(const size_t dimension, const size_t count)
+    {
+        m_dimension = dimension;
+        m_count = count;
+        m_stride = (count + PADDING - 1U) / PADDING * PADDING;
+        m_data.assign(m_dimension * m_stride, T{0});
+    }
+
+    [[nodiscard]] size_t dimension() const
+    {
+        return m_dimension;
+    }
+
+    [[nodiscard]] size_t count() const
+    {
+        return m_count;
+    }
+
+    /**
+     * Return the lanes of a component
+     */
+    T* component(const size_t index)
+    {
+        assert(index < m_dimension);
+        return m_data.data() + index * m_stride;
+    }
+
+    const T* component(const size_t index) const
+    {
+        assert(index < m_dimension);
+        return m_data.data() + index * m_stride;
+    }
+
+    T& operator()(const size_t index, const size_t lane)
+    {
+        assert(lane < m_count);
+        return component(index)[lane];
+    }
+
+    T operator()(const size_t index, const size_t lane) const
+    {
+        assert(lane < m_count);
+        return component(index)[lane];
+    }
+
+    /**
+     * Return all values including padding lanes
+     */
+    Vector<T>& data()
+    {
+        return m_data;
+    }
+
+    const Vector<T>& data() const
+    {
+        return m_data;
+    }
+
+private:
+    size_t m_dimension{0U}; //!< Components per instance
+    size_t m_count{0U}; //!< Number of instances
+    size_t m_stride{0U}; //!< Distance between components
+    Vector<T> m_data{}; //!< Component major values
+};
+}
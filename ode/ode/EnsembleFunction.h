@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Ensemble.h"
+
+namespace ode
+{
+/**
+ * @brief EnsembleFunction class
+ */
+template<typename T, typename Enable = void>
+class EnsembleFunction;
+
+template<typename T>
+class EnsembleFunction<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    /**
+     * Calculate derivative of all instances
+     * @param x      Step variable
+     * @param y      Parameters of all instances
+     * @param dydx   Calculated derivatives of all instances, same shape as y
+     */
+    virtual void derive(T x, const Ensemble<T>& y, Ensemble<T>& dydx) = 0;
+};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "EnsembleFunction.h"
+
+namespace ode
+{
+/**
+ * @brief EnsembleRungeKutta class
+ *
+ * Classical 4th order Runge Kutta step of all instances of an ensemble. Each
+ * stage calls the derivative once for all instances, the stage combinations
+ * run as single loops over the whole ensemble.
+ */
+template<typename T, typename Enable = void>
+class EnsembleRungeKutta;
+
+template<typename T>
+class EnsembleRungeKutta<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    EnsembleRungeKutta() = default;
+
+    /**
+     * Calculate integration step
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Ode function
+     * @param y          Parameters of all instances, updated in place
+     */
+    void calc(T x, T dx, EnsembleFunction<T>& function, Ensemble<T>& y)
+    {
+        resize(y);
+
+        function.derive(x, y, m_k1);
+        m_yx.data() = y.data() + m_k1.data() * (dx / T{2});
+
+        function.derive(x + dx / T{2}, m_yx, m_k2);
+        m_yx.data() = y.data() + m_k2.data() * (dx / T{2});
+
+        function.derive(x + dx / T{2}, m_yx, m_k3);
+        m_yx.data() = y.data() + m_k3.data() * dx;
+
+        function.derive(x + dx, m_yx, m_k4);
+        y.data() += (m_k1.data() + m_k2.data() * T{2} + m_k3.data() * T{2} + m_k4.data()) * (dx / T{6});
+    }
+
+private:
+    void resize(const Ensemble<T>& y)
+    {
+        if (m_yx.dimension() != y.dimension() || m_yx.count() != y.count())
+        {
+            m_yx.resize(y.dimension(), y.count());
+            m_k1.resize(y.dimension(), y.count());
+            m_k2.resize(y.dimension(), y.count());
+            m_k3.resize(y.dimension(), y.count());
+            m_k4.resize(y.dimension(), y.count());
+        }
+    }
+
+    Ensemble<T> m_yx{}; //!< Stage parameters
+    Ensemble<T> m_k1{}; //!< Stages
+    Ensemble<T> m_k2{};
+    Ensemble<T> m_k3{};
+    Ensemble<T> m_k4{};
+};
+}
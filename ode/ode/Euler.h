@@ -1,29 +1,12 @@
 #pragma once
 
-#include "Solver.h"
+#include "ExplicitRungeKutta.h"
 
 namespace ode
 {
 /**
- * @brief Euler class
+ * @brief Euler solver
  */
-template<typename T>
-class Euler : public Solver<T>
-{
-public:
-    Euler() = default;
-
-    Vector<T> calc(T x, T dx, Function<T>& function) final
-    {
-        Vector<T> y{function.getParams()};
-        Vector<T> dy(y.size());
-        Vector<T> dydx{function.derive(x, y)};
-        for (size_t i{0U}; i < y.size(); ++i)
-        {
-            dy[i] = dydx[i] * dx;
-        }
-        function.setParams(dy);
-        return dy;
-    }
-};
+template<typename T, size_t N = Dynamic>
+using Euler = ExplicitRungeKutta<T, tableau::Euler, N>;
 }
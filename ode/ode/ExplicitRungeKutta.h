@@ -0,0 +1,237 @@
+#pragma once
+
+#include "ButcherTableau.h"
+#include "DenseOutput.h"
+#include "Solver.h"
+#include "StaticFunction.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ode
+{
+/**
+ * @brief ExplicitRungeKutta class
+ *
+ * Explicit Runge Kutta method given by a Butcher tableau, see
+ * ButcherTableau.h. The stages are unrolled at compile time and terms with
+ * zero coefficients are skipped, each stage combination is a single loop.
+ */
+template<typename T, typename Tableau, size_t N = Dynamic>
+class ExplicitRungeKutta : public Solver<T, N>
+{
+    static constexpr size_t STAGES{Tableau::STAGES};
+
+public:
+    ExplicitRungeKutta() = default;
+
+    using Solver<T, N>::calc;
+
+    void calc(T x, T dx, Function<T, N>& function, Workspace<T, N>& workspace) final
+    {
+        step(x, dx, function, workspace);
+    }
+
+    /**
+     * Calculate integration step without virtual dispatch
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Ode function, see StaticFunction.h
+     * @param workspace  Reusable buffers, the calculated parameters are stored in workspace.dy
+     */
+    template<typename F>
+    void step(T x, T dx, F& function, Workspace<T, N>& workspace)
+    {
+        static_assert(isExplicit(), "Tableau must be strictly lower triangular");
+
+        ode::getParams(function, workspace.y);
+        workspace.resize(STAGES, workspace.y.size());
+
+        stages(x, dx, function, workspace, std::make_index_sequence<STAGES>{});
+
+        // dy = dx * sum(B[j] * k[j])
+        combine<STAGES>(workspace.dy, dx, workspace, std::make_index_sequence<STAGES>{});
+        function.setParams(workspace.dy);
+    }
+
+    /**
+     * Integrate with dense output
+     *
+     * The parameters of the function are sampled at x0 + k * interval by
+     * cubic Hermite interpolation. The derivative at the end of a step is the
+     * first stage of the next step, so sampling needs a single additional
+     * derivative evaluation at the end of the range only.
+     * @param x0         Start variable
+     * @param y0         Start parameters
+     * @param x          End variable
+     * @param dx         Variable step
+     * @param function   Ode function, see StaticFunction.h
+     * @param interval   Sample interval
+     * @param output     Called with each sample as output(xk, yk)
+     * @return calculated parameters
+     */
+    template<typename F, typename O>
+    Vector<T, N> stepRange(T x0, const Vector<T, N>& y0, T x, T dx, F& function, T interval, O&& output)
+    {
+        Vector<T, N> y{y0};
+        Vector<T, N> sample{y0};
+        Workspace<T, N> workspace{};
+        DenseOutput<T, N> dense{};
+        size_t samples{0U};
+        T next{x0};
+        auto emit = [&](const T end) {
+            const T tolerance{T{64} * std::numeric_limits<T>::epsilon() * std::max(std::abs(end), T{1})};
+            while (interval > T{0} && next <= end + tolerance)
+            {
+                dense.interpolate(next, sample);
+                output(next, static_cast<const Vector<T, N>&>(sample));
+                next = x0 + static_cast<T>(++samples) * interval;
+            }
+        };
+
+        T t{x0};
+        bool first{true};
+        while (t < x)
+        {
+            const T h{std::min(dx, x - t)};
+            step(t, h, function, workspace);
+            if (first)
+            {
+                dense.begin(t, workspace.y, workspace.k[0U]);
+                first = false;
+            }
+            else
+            {
+                dense.end(t, workspace.y, workspace.k[0U]);
+                emit(t);
+                dense.advance();
+            }
+            y += workspace.dy;
+            t += h;
+        }
+
+        // Derivative at the end of the range
+        ode::getParams(function, workspace.y);
+        workspace.resize(STAGES, workspace.y.size());
+        ode::derive(function, t, workspace.y, workspace.dydx);
+        if (first)
+        {
+            dense.begin(t, workspace.y, workspace.dydx);
+        }
+        dense.end(t, workspace.y, workspace.dydx);
+        emit(t);
+        return y;
+    }
+
+private:
+    static constexpr bool isExplicit()
+    {
+        for (size_t i{0U}; i < STAGES; ++i)
+        {
+            for (size_t j{i}; j < STAGES; ++j)
+            {
+                if (Tableau::A[i][j] != 0.)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Return weight J of tableau row Row, the row STAGES are the solution weights B
+     */
+    template<size_t Row, size_t J>
+    static constexpr double weight()
+    {
+        if constexpr (Row == STAGES)
+        {
+            return Tableau::B[J];
+        }
+        else
+        {
+            return Tableau::A[Row][J];
+        }
+    }
+
+    template<size_t Row, size_t... J>
+    static constexpr bool isZero(std::index_sequence<J...>)
+    {
+        return ((weight<Row, J>() == 0.) && ...);
+    }
+
+    template<typename F, size_t... I>
+    static void stages(T x, T dx, F& function, Workspace<T, N>& workspace, std::index_sequence<I...>)
+    {
+        (stage<I>(x, dx, function, workspace), ...);
+    }
+
+    /**
+     * Calculate stage k[I] = f(x + C[I] * dx, y + dx * sum(A[I][j] * k[j]))
+     */
+    template<size_t I, typename F>
+    static void stage(T x, T dx, F& function, Workspace<T, N>& workspace)
+    {
+        if constexpr (isZero<I>(std::make_index_sequence<I>{}))
+        {
+            ode::derive(function, x + static_cast<T>(Tableau::C[I]) * dx, workspace.y, workspace.k[I]);
+        }
+        else
+        {
+            combine<I>(workspace.yx, dx, workspace, std::make_index_sequence<I>{});
+            ode::derive(function, x + static_cast<T>(Tableau::C[I]) * dx, workspace.yx, workspace.k[I]);
+        }
+    }
+
+    /**
+     * Calculate out = y + dx * sum(A[Row][j] * k[j]) or out = dx * sum(B[j] * k[j]) for Row = STAGES
+     */
+    template<size_t Row, size_t... J>
+    static void combine(Vector<T, N>& out, T dx, Workspace<T, N>& workspace, std::index_sequence<J...>)
+    {
+        const size_t size{out.size()};
+        if constexpr (N == Dynamic)
+        {
+            if (size >= simd::THRESHOLD)
+            {
+                // Non zero terms only
+                const T* k[STAGES]{};
+                T w[STAGES]{};
+                size_t terms{0U};
+                ((weight<Row, J>() != 0. ? (k[terms] = workspace.k[J].data(), w[terms++] = static_cast<T>(weight<Row, J>())) : T{0}), ...);
+                simd::kernels<T>().combine(out.data(), Row == STAGES ? nullptr : workspace.y.data(), dx, k, w, terms, size);
+                return;
+            }
+        }
+
+        const T* k[STAGES]{};
+        ((k[J] = workspace.k[J].data()), ...);
+
+        const T* y{workspace.y.data()};
+        T* result{out.data()};
+        for (size_t i{0U}; i < size; ++i)
+        {
+            T sum{0};
+            (accumulate<Row, J>(sum, k[J][i]), ...);
+            if constexpr (Row == STAGES)
+            {
+                result[i] = dx * sum;
+            }
+            else
+            {
+                result[i] = y[i] + dx * sum;
+            }
+        }
+    }
+
+    template<size_t Row, size_t J>
+    static void accumulate(T& sum, const T k)
+    {
+        if constexpr (weight<Row, J>() != 0.)
+        {
+            sum += static_cast<T>(weight<Row, J>()) * k;
+        }
+    }
+};
+}
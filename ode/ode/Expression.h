@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+namespace ode
+{
+/**
+ * @brief Expression class
+ *
+ * Base of all lazily evaluated vector expressions. An expression is evaluated
+ * element by element on assignment to a vector, so `y = y + k1 * 0.5` runs a
+ * single loop without temporaries.
+ *
+ * Expressions keep references to the vectors they are built from, don't store
+ * them in `auto` variables beyond the lifetime of the operands.
+ */
+template<typename E>
+class Expression
+{
+public:
+    const E& self() const
+    {
+        return static_cast<const E&>(*this);
+    }
+};
+
+/**
+ * @brief Storage of an expression operand
+ *
+ * Expression nodes are stored by value, vectors by reference.
+ */
+template<typename E>
+struct Operand
+{
+    using Type = const E;
+};
+
+/**
+ * @brief Elementwise operations
+ */
+struct Add
+{
+    template<typename T>
+    static T apply(const T a, const T b)
+    {
+        return a + b;
+    }
+};
+
+struct Subtract
+{
+    template<typename T>
+    static T apply(const T a, const T b)
+    {
+        return a - b;
+    }
+};
+
+struct Multiply
+{
+    template<typename T>
+    static T apply(const T a, const T b)
+    {
+        return a * b;
+    }
+};
+
+struct Divide
+{
+    template<typename T>
+    static T apply(const T a, const T b)
+    {
+        return a / b;
+    }
+};
+
+/**
+ * @brief Vector op vector expression
+ */
+template<typename L, typename R, typename Op>
+class BinaryExpression : public Expression<BinaryExpression<L, R, Op>>
+{
+public:
+    using value_type = typename L::value_type;
+
+    BinaryExpression(const L& lhs, const R& rhs)
+        : m_lhs{lhs}
+        , m_rhs{rhs}
+    {
+        assert(lhs.size() == rhs.size());
+    }
+
+    size_t size() const
+    {
+        return m_lhs.size();
+    }
+
+    value_type operator[](const size_t i) const
+    {
+        return Op::apply(m_lhs[i], m_rhs[i]);
+    }
+
+private:
+    typename Operand<L>::Type m_lhs;
+    typename Operand<R>::Type m_rhs;
+};
+
+/**
+ * @brief Vector op scalar expression
+ */
+template<typename E, typename Op>
+class ScalarExpression : public Expression<ScalarExpression<E, Op>>
+{
+public:
+    using value_type = typename E::value_type;
+
+    ScalarExpression(const E& expression, const value_type x)
+        : m_expression{expression}
+        , m_x{x}
+    {
+    }
+
+    size_t size() const
+    {
+        return m_expression.size();
+    }
+
+    value_type operator[](const size_t i) const
+    {
+        return Op::apply(m_expression[i], m_x);
+    }
+
+private:
+    typename Operand<E>::Type m_expression;
+    value_type m_x;
+};
+
+/**
+ * @brief Negated vector expression
+ */
+template<typename E>
+class NegateExpression : public Expression<NegateExpression<E>>
+{
+public:
+    using value_type = typename E::value_type;
+
+    explicit NegateExpression(const E& expression)
+        : m_expression{expression}
+    {
+    }
+
+    size_t size() const
+    {
+        return m_expression.size();
+    }
+
+    value_type operator[](const size_t i) const
+    {
+        return -m_expression[i];
+    }
+
+private:
+    typename Operand<E>::Type m_expression;
+};
+
+template<typename L, typename R>
+BinaryExpression<L, R, Add> operator+(const Expression<L>& lhs, const Expression<R>& rhs)
+{
+    return BinaryExpression<L, R, Add>(lhs.self(), rhs.self());
+}
+
+template<typename L, typename R>
+BinaryExpression<L, R, Subtract> operator-(const Expression<L>& lhs, const Expression<R>& rhs)
+{
+    return BinaryExpression<L, R, Subtract>(lhs.self(), rhs.self());
+}
+
+template<typename E>
+ScalarExpression<E, Add> operator+(const Expression<E>& lhs, const typename E::value_type x)
+{
+    return ScalarExpression<E, Add>(lhs.self(), x);
+}
+
+template<typename E>
+ScalarExpression<E, Subtract> operator-(const Expression<E>& lhs, const typename E::value_type x)
+{
+    return ScalarExpression<E, Subtract>(lhs.self(), x);
+}
+
+template<typename E>
+ScalarExpression<E, Multiply> operator*(const Expression<E>& lhs, const typename E::value_type x)
+{
+    return ScalarExpression<E, Multiply>(lhs.self(), x);
+}
+
+template<typename E>
+ScalarExpression<E, Multiply> operator*(const typename E::value_type x, const Expression<E>& rhs)
+{
+    return ScalarExpression<E, Multiply>(rhs.self(), x);
+}
+
+template<typename E>
+ScalarExpression<E, Divide> operator/(const Expression<E>& lhs, const typename E::value_type x)
+{
+    assert(x != typename E::value_type{0});
+    return ScalarExpression<E, Divide>(lhs.self(), x);
+}
+
+template<typename E>
+const E& operator+(const Expression<E>& rhs)
+{
+    return rhs.self();
+}
+
+template<typename E>
+NegateExpression<E> operator-(const Expression<E>& rhs)
+{
+    return NegateExpression<E>(rhs.self());
+}
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+#include "Trajectory.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ode
+{
+/**
+ * @brief FrameWriter class
+ *
+ * Writes frames of values as text rows or in the binary trajectory format,
+ * see Trajectory.h, from a background thread. The
+ * simulation thread copies a frame into a slot of a lock free single
+ * producer single consumer ring buffer, the writer thread formats the
+ * frames with std::to_chars and writes them to the outputs in large
+ * batches. A stride queues only every n-th pushed frame. A full ring
+ * either blocks the simulation thread, drops the frame or increases the
+ * decimation of the following frames, see Policy.
+ */
+template<typename T, typename Enable = void>
+class FrameWriter;
+
+template<typename T>
+class FrameWriter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    /**
+     * @brief Behaviour if the writer falls behind
+     */
+    enum class Policy
+    {
+        Block, //!< Wait for a free slot
+        Drop, //!< Drop the frame
+        Decimate //!< Drop the frame and double the decimation, which halves again once the ring is drained
+    };
+
+    /**
+     * Create writer
+     * @param capacity   Number of frames in the ring buffer
+     * @param policy     Behaviour if the ring buffer is full
+     */
+    explicit FrameWriter(const size_t capacity = 64U, const Policy policy = Policy::Block)
+        : m_slots(std::max<size_t>(capacity, 1U))
+        , m_policy{policy}
+    {
+    }
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    ~FrameWriter()
+    {
+        close();
+    }
+
+    /**
+     * Return the policy of the given name (block, drop, decimate), Block if unknown
+     */
+    static Policy toPolicy(const std::string& name)
+    {
+        return name == "drop" ? Policy::Drop : name == "decimate" ? Policy::Decimate : Policy::Block;
+    }
+
+    void setPolicy(const Policy policy)
+    {
+        m_policy = policy;
+    }
+
+    /**
+     * Sample the pushed frames
+     *
+     * The stride is applied before the policy, a decimation of d by Policy::Decimate
+     * queues only every (stride * d)-th pushed frame until the writer has caught up.
+     * @param stride     Every stride-th frame is queued, the others are skipped without formatting
+     * @param phase      Number of frames pushed before, e.g. by the run continued from a checkpoint
+     */
+    void setStride(const size_t stride, const size_t phase = 0U)
+    {
+        m_stride = std::max<size_t>(stride, 1U);
+        m_pushed = phase;
+    }
+
+    /**
+     * Add an output file, which receives the values [first, first + count) of each frame as row
+     *
+     * Outputs must be added before the first push, which starts the writer thread.
+     * @return false if the file can't be opened or the writer thread runs, the output isn't added then
+     */
+    bool open(const std::string& filename, const size_t first, const size_t count)
+    {
+        if (m_thread.joinable())
+        {
+            return false;
+        }
+        m_outputs.emplace_back();
+        Output& output{m_outputs.back()};
+        output.file.open(filename, std::ios::out | std::ios::trunc);
+        output.first = first;
+        output.count = count;
+        if (!output.file.good())
+        {
+            m_outputs.pop_back();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Add a binary trajectory output, which receives the values [first, first + count) of each frame
+     *
+     * Outputs must be added before the first push, which starts the writer thread.
+     * @param filename   File name
+     * @param first      First value
+     * @param count      Number of values, a multiple of dimension
+     * @param dimension  Values per particle
+     * @param timeStep   Variable step stored in the header
+     * @return false if the file can't be created or the writer thread runs, the output isn't added then
+     */
+    bool openBinary(const std::string& filename, const size_t first, const size_t count, const size_t dimension, const double timeStep)
+    {
+        if (m_thread.joinable())
+        {
+            return false;
+        }
+        m_outputs.emplace_back();
+        Output& output{m_outputs.back()};
+        output.first = first;
+        output.count = count;
+        if (!output.trajectory.open(filename, count / dimension, dimension, timeStep))
+        {
+            m_outputs.pop_back();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Queue a frame
+     * @param x          Variable
+     * @param size       Number of values
+     * @param fill       Copies the values into the given array as fill(values)
+     * @return false if the frame was skipped by the stride, dropped or decimated
+     */
+    template<typename F>
+    bool push(const double x, const size_t size, F&& fill)
+    {
+        if (m_outputs.empty() || m_pushed++ % m_stride != 0U)
+        {
+            return false;
+        }
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread([this]() { work(); });
+        }
+        if (++m_skipped < m_decimation)
+        {
+            ++m_dropped;
+            return false;
+        }
+        m_skipped = 0U;
+
+        const size_t tail{m_tail.load(std::memory_order_relaxed)};
+        const size_t capacity{m_slots.size()};
+        while (tail - m_head.load(std::memory_order_acquire) >= capacity)
+        {
+            if (m_policy != Policy::Block)
+            {
+                if (m_policy == Policy::Decimate)
+                {
+                    m_decimation *= 2U;
+                }
+                ++m_dropped;
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        if (m_policy == Policy::Decimate && m_decimation > 1U && tail == m_head.load(std::memory_order_acquire))
+        {
+            m_decimation /= 2U;
+        }
+
+        Frame& frame{m_slots[tail % capacity]};
+        frame.x = x;
+        frame.values.resize(size);
+        fill(frame.values.data());
+        m_tail.store(tail + 1U, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Write all queued frames and close the outputs
+     */
+    void close()
+    {
+        if (m_thread.joinable())
+        {
+            m_stop.store(true, std::memory_order_release);
+            m_thread.join();
+            m_stop.store(false, std::memory_order_relaxed);
+        }
+        for (auto& output : m_outputs)
+        {
+            flush(output);
+            output.file.close();
+            output.trajectory.close();
+        }
+        m_outputs.clear();
+    }
+
+    /**
+     * Number of written frames
+     */
+    [[nodiscard]] size_t written() const
+    {
+        return m_head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Number of dropped or decimated frames
+     */
+    [[nodiscard]] size_t dropped() const
+    {
+        return m_dropped;
+    }
+
+private:
+    struct Frame
+    {
+        double x{0.}; //!< Variable
+        std::vector<T> values{}; //!< Values
+    };
+
+    struct Output
+    {
+        std::ofstream file{}; //!< Text output file
+        TrajectoryWriter<T> trajectory{}; //!< Binary output file
+        std::string buffer{}; //!< Formatted rows not yet written
+        size_t first{0U}; //!< First value of a row
+        size_t count{0U}; //!< Number of values of a row
+    };
+
+    //! Size of the formatted rows of an output that triggers a write
+    static constexpr size_t BATCH{1U << 20U};
+    //! Maximum length of a formatted value with separator
+    static constexpr size_t DIGITS{32U};
+
+    void work()
+    {
+        for (;;)
+        {
+            const size_t head{m_head.load(std::memory_order_relaxed)};
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                if (m_stop.load(std::memory_order_acquire))
+                {
+                    if (head == m_tail.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+                    continue;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+
+            const Frame& frame{m_slots[head % m_slots.size()]};
+            for (auto& output : m_outputs)
+            {
+                if (output.trajectory.isOpen())
+                {
+                    output.trajectory.write(frame.x, frame.values.data() + output.first);
+                }
+                else
+                {
+                    format(output, frame.values);
+                }
+            }
+            m_head.store(head + 1U, std::memory_order_release);
+        }
+    }
+
+    static void format(Output& output, const std::vector<T>& values)
+    {
+        // Shortest text of 6 significant digits like %g, written in place into the batch
+        const size_t end{std::min(output.first + output.count, values.size())};
+        const size_t size{output.buffer.size()};
+        output.buffer.resize(size + (end - std::min(output.first, end)) * DIGITS + 1U);
+        char* text{output.buffer.data() + size};
+        for (size_t i{output.first}; i < end; ++i)
+        {
+            text = std::to_chars(text, text + DIGITS - 1U, values[i], std::chars_format::general, 6).ptr;
+            *text++ = '\t';
+        }
+        *text++ = '\n';
+        output.buffer.resize(static_cast<size_t>(text - output.buffer.data()));
+        if (output.buffer.size() >= BATCH)
+        {
+            flush(output);
+        }
+    }
+
+    static void flush(Output& output)
+    {
+        if (output.buffer.empty())
+        {
+            return;
+        }
+        output.file.write(output.buffer.data(), static_cast<std::streamsize>(output.buffer.size()));
+        output.buffer.clear();
+    }
+
+    std::vector<Frame> m_slots{}; //!< Ring buffer of frames
+    alignas(64) std::atomic<size_t> m_head{0U}; //!< Next frame to write, advanced by the writer thread
+    alignas(64) std::atomic<size_t> m_tail{0U}; //!< Next free slot, advanced by the simulation thread
+    std::atomic<bool> m_stop{false}; //!< Writer thread terminates once the ring is drained
+    std::vector<Output> m_outputs{};
+    std::thread m_thread{};
+    Policy m_policy{Policy::Block};
+    size_t m_decimation{1U}; //!< Every m_decimation-th frame is queued
+    size_t m_skipped{0U}; //!< Frames since the last queued frame
+    size_t m_dropped{0U}; //!< Number of dropped frames
+    size_t m_stride{1U}; //!< Every m_stride-th pushed frame is queued
+    size_t m_pushed{0U}; //!< Number of pushed frames
+};
+
+/**
+ * Split a binary trajectory into one text file per particle
+ *
+ * The files are written by a FrameWriter per group of particles, so the
+ * number of open files stays bounded for any number of particles.
+ * @param reader     Opened trajectory
+ * @param first      First particle
+ * @param count      Number of particles
+ * @param name       Function returning the file name of particle i as name(i)
+ * @return number of written files
+ */
+template<typename T, typename N>
+size_t split(const TrajectoryReader<T>& reader, const size_t first, const size_t count, N&& name)
+{
+    static constexpr size_t FILES{64U}; //!< Files written at the same time
+    const size_t dimension{reader.dimension()};
+    const size_t end{std::min(first + count, reader.particles())};
+    size_t files{0U};
+    for (size_t begin{first}; begin < end; begin += FILES)
+    {
+        const size_t group{std::min(FILES, end - begin)};
+        FrameWriter<T> writer{};
+        for (size_t i{0U}; i < group; ++i)
+        {
+            files += writer.open(name(begin + i), i * dimension, dimension) ? 1U : 0U;
+        }
+        for (size_t k{0U}; k < reader.frames(); ++k)
+        {
+            const T* frame{reader.frame(k) + begin * dimension};
+            writer.push(reader.variable(k), group * dimension, [&](T* values) { std::copy(frame, frame + group * dimension, values); });
+        }
+    }
+    return files;
+}
+}
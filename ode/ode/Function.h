@@ -7,11 +7,11 @@ namespace ode
 /**
  * @brief OdeFunction class
  */
-template<typename T, typename Enable = void>
+template<typename T, size_t N = Dynamic, typename Enable = void>
 class Function;
 
-template<typename T>
-class Function<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+template<typename T, size_t N>
+class Function<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type>
 {
 public:
     /**
@@ -20,7 +20,7 @@ public:
      * @param y      List of parameters
      * @return List of calculated parameters
      */
-    virtual Vector<T> derive(T x, Vector<T>& y) = 0;
+    virtual Vector<T, N> derive(T x, Vector<T, N>& y) = 0;
 
     /**
      * Calculate derivative
@@ -29,20 +29,52 @@ public:
      * @param dy     List of derived parameters
      * @return List of calculated parameters
      */
-    virtual Vector<T> derive2([[maybe_unused]] T x, [[maybe_unused]] Vector<T>& y, [[maybe_unused]] Vector<T>& dy)
+    virtual Vector<T, N> derive2([[maybe_unused]] T x, [[maybe_unused]] Vector<T, N>& y, [[maybe_unused]] Vector<T, N>& dy)
     {
-        return Vector<T>{};
+        return Vector<T, N>{};
+    }
+
+    /**
+     * Calculate derivative into a caller provided buffer
+     * @param x      Step variable
+     * @param y      List of parameters
+     * @param dydx   List of calculated parameters
+     */
+    virtual void derive(T x, Vector<T, N>& y, Vector<T, N>& dydx)
+    {
+        dydx = derive(x, y);
+    }
+
+    /**
+     * Calculate 2nd derivative into a caller provided buffer
+     * @param x      Step variable
+     * @param y      List of parameters
+     * @param dy     List of derived parameters
+     * @param dyd2x  List of calculated parameters
+     */
+    virtual void derive2(T x, Vector<T, N>& y, Vector<T, N>& dy, Vector<T, N>& dyd2x)
+    {
+        dyd2x = derive2(x, y, dy);
     }
 
     /**
      * Return a vector with the parameters to the solver
      */
-    virtual Vector<T> getParams() const = 0;
+    virtual Vector<T, N> getParams() const = 0;
+
+    /**
+     * Copy the parameters to the solver into a caller provided buffer
+     * @param y      List of parameters
+     */
+    virtual void getParams(Vector<T, N>& y) const
+    {
+        y = getParams();
+    }
 
     /**
      * Callback of OdeSolver result parameters
      * @param y      Result parameters
      */
-    virtual void setParams(const Vector<T>& y) = 0;
+    virtual void setParams(const Vector<T, N>& y) = 0;
 };
 }
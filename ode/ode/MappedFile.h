@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ODE_MAPPED_FILE_MMAP 1
+#endif
+
+namespace ode
+{
+/**
+ * @brief MappedFile class
+ *
+ * Read only view of a file, which is mapped into memory. Systems without
+ * mmap read the file into a buffer instead.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    /**
+     * Map file
+     * @return false if the file can't be read or is empty
+     */
+#ifdef ODE_MAPPED_FILE_MMAP
+    bool open(const std::string& filename)
+    {
+        close();
+        const int descriptor{::open(filename.c_str(), O_RDONLY)};
+        if (descriptor < 0)
+        {
+            return false;
+        }
+        struct stat status{};
+        if (::fstat(descriptor, &status) != 0 || status.st_size <= 0)
+        {
+            ::close(descriptor);
+            return false;
+        }
+        m_size = static_cast<size_t>(status.st_size);
+        void* data{::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+        ::close(descriptor);
+        if (data == MAP_FAILED)
+        {
+            m_size = 0U;
+            return false;
+        }
+        m_data = static_cast<const char*>(data);
+        return true;
+    }
+
+    void close()
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0U;
+    }
+#else
+    bool open(const std::string& filename)
+    {
+        close();
+        std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.good())
+        {
+            return false;
+        }
+        m_buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        return file.good() && m_size > 0U;
+    }
+
+    void close()
+    {
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0U;
+    }
+#endif
+
+    [[nodiscard]] const char* data() const
+    {
+        return m_data;
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+#ifndef ODE_MAPPED_FILE_MMAP
+    std::vector<char> m_buffer{}; //!< File content without memory mapping
+#endif
+    const char* m_data{nullptr}; //!< Mapped file
+    size_t m_size{0U}; //!< File size
+};
+}
@@ -1,42 +1,12 @@
 #pragma once
 
-#include "Solver.h"
+#include "ExplicitRungeKutta.h"
 
 namespace ode
 {
 /**
- * @brief MidPoint class
+ * @brief MidPoint solver
  */
-template<typename T>
-class MidPoint : public Solver<T>
-{
-public:
-    MidPoint() = default;
-
-    Vector<T> calc(T x, T dx, Function<T>& function) final
-    {
-        Vector<T> y{function.getParams()};
-        Vector<T> dy(y.size());
-        Vector<T> dydx{function.derive(x, y)};
-
-        Vector<T> k1(y.size());
-        for (size_t i{0U}; i < y.size(); ++i)
-        {
-            k1[i] = dx * dydx[i];
-        }
-        Vector<T> yt(y.size());
-        for (size_t i{0U}; i < y.size(); ++i)
-        {
-            yt[i] = y[i] + k1[i] / 2.F;
-        }
-
-        dydx = function.derive(x + dx / 2.F, yt);
-        for (size_t i{0U}; i < y.size(); ++i)
-        {
-            dy[i] = dx * dydx[i];
-        }
-        function.setParams(dy);
-        return dy;
-    }
-};
-}
\ No newline at end of file
+template<typename T, size_t N = Dynamic>
+using MidPoint = ExplicitRungeKutta<T, tableau::MidPoint, N>;
+}
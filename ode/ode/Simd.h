@@ -0,0 +1,470 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ODE_SIMD_X86 1
+#endif
+
+namespace ode
+{
+/**
+ * @brief Vectorized kernels with run time instruction set dispatch
+ *
+ * The kernels operate on contiguous arrays. `kernels<T>()` returns the
+ * kernels of the best instruction set supported by the CPU, detected once on
+ * first use. The environment variable `ODE_SIMD` (scalar, sse2, avx2, avx512)
+ * limits the selection, e.g. to compare kernels. Targets other than x86 with
+ * GCC or Clang use the scalar kernels.
+ */
+namespace simd
+{
+/**
+ * @brief Instruction sets
+ */
+enum class Isa
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512
+};
+
+//! Minimum number of elements for which vectors dispatch to the kernels
+static constexpr size_t THRESHOLD{32U};
+
+/**
+ * @brief Kernel table of an instruction set
+ */
+template<typename T>
+struct Kernels
+{
+    Isa isa; //!< Instruction set
+    T (*dot)(const T* x, const T* y, size_t size); //!< sum(x[i] * y[i])
+    T (*norm1)(const T* x, size_t size); //!< sum(|x[i]|)
+    T (*sumSquares)(const T* x, size_t size); //!< sum(x[i]^2)
+    T (*normInf)(const T* x, size_t size); //!< max(|x[i]|), NaN if any x[i] is NaN
+    void (*axpy)(T a, const T* x, T* y, size_t size); //!< y[i] += a * x[i]
+    void (*combine)(T* out, const T* y, T a, const T* const* k, const T* w, size_t terms, size_t size); //!< out[i] = y[i] + a * sum(w[j] * k[j][i]), y may be null
+};
+
+/**
+ * @brief Scalar kernels
+ */
+template<typename T>
+struct Scalar
+{
+    static T dot(const T* x, const T* y, const size_t size)
+    {
+        T result{0};
+        for (size_t i{0U}; i < size; ++i)
+        {
+            result += x[i] * y[i];
+        }
+        return result;
+    }
+
+    static T norm1(const T* x, const size_t size)
+    {
+        T result{0};
+        for (size_t i{0U}; i < size; ++i)
+        {
+            result += std::abs(x[i]);
+        }
+        return result;
+    }
+
+    static T sumSquares(const T* x, const size_t size)
+    {
+        return dot(x, x, size);
+    }
+
+    static T normInf(const T* x, const size_t size)
+    {
+        T result{0};
+        for (size_t i{0U}; i < size; ++i)
+        {
+            if (std::isnan(x[i]))
+            {
+                return x[i];
+            }
+            result = std::max(result, std::abs(x[i]));
+        }
+        return result;
+    }
+
+    static void axpy(const T a, const T* x, T* y, const size_t size)
+    {
+        for (size_t i{0U}; i < size; ++i)
+        {
+            y[i] += a * x[i];
+        }
+    }
+
+    static void combine(T* out, const T* y, const T a, const T* const* k, const T* w, const size_t terms, const size_t size)
+    {
+        for (size_t i{0U}; i < size; ++i)
+        {
+            T sum{0};
+            for (size_t j{0U}; j < terms; ++j)
+            {
+                sum += w[j] * k[j][i];
+            }
+            out[i] = (y != nullptr ? y[i] : T{0}) + a * sum;
+        }
+    }
+};
+
+#ifdef ODE_SIMD_X86
+/**
+ * @brief Generic kernels on vectors of BYTES size
+ *
+ * The kernels are inlined into the instruction set specific entry points
+ * below, which compile them for their target.
+ */
+template<typename T, size_t BYTES>
+struct Pack
+{
+    typedef T Type __attribute__((vector_size(BYTES)));
+    static constexpr size_t WIDTH{BYTES / sizeof(T)};
+
+    __attribute__((always_inline)) static inline T dot(const T* x, const T* y, const size_t size)
+    {
+        Type acc0{};
+        Type acc1{};
+        size_t i{0U};
+        for (; i + 2U * WIDTH <= size; i += 2U * WIDTH)
+        {
+            Type x0, x1, y0, y1;
+            std::memcpy(&x0, x + i, BYTES);
+            std::memcpy(&x1, x + i + WIDTH, BYTES);
+            std::memcpy(&y0, y + i, BYTES);
+            std::memcpy(&y1, y + i + WIDTH, BYTES);
+            acc0 += x0 * y0;
+            acc1 += x1 * y1;
+        }
+        acc0 += acc1;
+        T result{0};
+        for (size_t j{0U}; j < WIDTH; ++j)
+        {
+            result += acc0[j];
+        }
+        for (; i < size; ++i)
+        {
+            result += x[i] * y[i];
+        }
+        return result;
+    }
+
+    __attribute__((always_inline)) static inline T norm1(const T* x, const size_t size)
+    {
+        const Type zero{};
+        Type acc{};
+        size_t i{0U};
+        for (; i + WIDTH <= size; i += WIDTH)
+        {
+            Type v;
+            std::memcpy(&v, x + i, BYTES);
+            acc += v < zero ? -v : v;
+        }
+        T result{0};
+        for (size_t j{0U}; j < WIDTH; ++j)
+        {
+            result += acc[j];
+        }
+        for (; i < size; ++i)
+        {
+            result += std::abs(x[i]);
+        }
+        return result;
+    }
+
+    __attribute__((always_inline)) static inline T normInf(const T* x, const size_t size)
+    {
+        const Type zero{};
+        Type acc{};
+        Type nan{};
+        size_t i{0U};
+        for (; i + WIDTH <= size; i += WIDTH)
+        {
+            Type v;
+            std::memcpy(&v, x + i, BYTES);
+            const Type a{v < zero ? -v : v};
+            acc = a > acc ? a : acc;
+            nan = v != v ? v : nan;
+        }
+        T result{0};
+        for (size_t j{0U}; j < WIDTH; ++j)
+        {
+            if (std::isnan(nan[j]))
+            {
+                return nan[j];
+            }
+            result = std::max(result, acc[j]);
+        }
+        for (; i < size; ++i)
+        {
+            if (std::isnan(x[i]))
+            {
+                return x[i];
+            }
+            result = std::max(result, std::abs(x[i]));
+        }
+        return result;
+    }
+
+    __attribute__((always_inline)) static inline void axpy(const T a, const T* x, T* y, const size_t size)
+    {
+        size_t i{0U};
+        for (; i + WIDTH <= size; i += WIDTH)
+        {
+            Type vx, vy;
+            std::memcpy(&vx, x + i, BYTES);
+            std::memcpy(&vy, y + i, BYTES);
+            vy += a * vx;
+            std::memcpy(y + i, &vy, BYTES);
+        }
+        for (; i < size; ++i)
+        {
+            y[i] += a * x[i];
+        }
+    }
+
+    __attribute__((always_inline)) static inline void combine(T* out, const T* y, const T a, const T* const* k, const T* w, const size_t terms, const size_t size)
+    {
+        size_t i{0U};
+        for (; i + WIDTH <= size; i += WIDTH)
+        {
+            Type sum{};
+            for (size_t j{0U}; j < terms; ++j)
+            {
+                Type v;
+                std::memcpy(&v, k[j] + i, BYTES);
+                sum += w[j] * v;
+            }
+            Type result{a * sum};
+            if (y != nullptr)
+            {
+                Type v;
+                std::memcpy(&v, y + i, BYTES);
+                result += v;
+            }
+            std::memcpy(out + i, &result, BYTES);
+        }
+        for (; i < size; ++i)
+        {
+            T sum{0};
+            for (size_t j{0U}; j < terms; ++j)
+            {
+                sum += w[j] * k[j][i];
+            }
+            out[i] = (y != nullptr ? y[i] : T{0}) + a * sum;
+        }
+    }
+};
+
+/**
+ * @brief SSE2 kernels
+ */
+template<typename T>
+struct Sse2
+{
+    using P = Pack<T, 16U>;
+
+    __attribute__((target("sse2"), flatten)) static T dot(const T* x, const T* y, const size_t size)
+    {
+        return P::dot(x, y, size);
+    }
+
+    __attribute__((target("sse2"), flatten)) static T norm1(const T* x, const size_t size)
+    {
+        return P::norm1(x, size);
+    }
+
+    __attribute__((target("sse2"), flatten)) static T sumSquares(const T* x, const size_t size)
+    {
+        return P::dot(x, x, size);
+    }
+
+    __attribute__((target("sse2"), flatten)) static T normInf(const T* x, const size_t size)
+    {
+        return P::normInf(x, size);
+    }
+
+    __attribute__((target("sse2"), flatten)) static void axpy(const T a, const T* x, T* y, const size_t size)
+    {
+        P::axpy(a, x, y, size);
+    }
+
+    __attribute__((target("sse2"), flatten)) static void combine(T* out, const T* y, const T a, const T* const* k, const T* w, const size_t terms, const size_t size)
+    {
+        P::combine(out, y, a, k, w, terms, size);
+    }
+};
+
+/**
+ * @brief AVX2 kernels with fused multiply add
+ */
+template<typename T>
+struct Avx2
+{
+    using P = Pack<T, 32U>;
+
+    __attribute__((target("avx2,fma"), flatten)) static T dot(const T* x, const T* y, const size_t size)
+    {
+        return P::dot(x, y, size);
+    }
+
+    __attribute__((target("avx2,fma"), flatten)) static T norm1(const T* x, const size_t size)
+    {
+        return P::norm1(x, size);
+    }
+
+    __attribute__((target("avx2,fma"), flatten)) static T sumSquares(const T* x, const size_t size)
+    {
+        return P::dot(x, x, size);
+    }
+
+    __attribute__((target("avx2,fma"), flatten)) static T normInf(const T* x, const size_t size)
+    {
+        return P::normInf(x, size);
+    }
+
+    __attribute__((target("avx2,fma"), flatten)) static void axpy(const T a, const T* x, T* y, const size_t size)
+    {
+        P::axpy(a, x, y, size);
+    }
+
+    __attribute__((target("avx2,fma"), flatten)) static void combine(T* out, const T* y, const T a, const T* const* k, const T* w, const size_t terms, const size_t size)
+    {
+        P::combine(out, y, a, k, w, terms, size);
+    }
+};
+
+/**
+ * @brief AVX-512 kernels
+ */
+template<typename T>
+struct Avx512
+{
+    using P = Pack<T, 64U>;
+
+    __attribute__((target("avx512f"), flatten)) static T dot(const T* x, const T* y, const size_t size)
+    {
+        return P::dot(x, y, size);
+    }
+
+    __attribute__((target("avx512f"), flatten)) static T norm1(const T* x, const size_t size)
+    {
+        return P::norm1(x, size);
+    }
+
+    __attribute__((target("avx512f"), flatten)) static T sumSquares(const T* x, const size_t size)
+    {
+        return P::dot(x, x, size);
+    }
+
+    __attribute__((target("avx512f"), flatten)) static T normInf(const T* x, const size_t size)
+    {
+        return P::normInf(x, size);
+    }
+
+    __attribute__((target("avx512f"), flatten)) static void axpy(const T a, const T* x, T* y, const size_t size)
+    {
+        P::axpy(a, x, y, size);
+    }
+
+    __attribute__((target("avx512f"), flatten)) static void combine(T* out, const T* y, const T a, const T* const* k, const T* w, const size_t terms, const size_t size)
+    {
+        P::combine(out, y, a, k, w, terms, size);
+    }
+};
+#endif
+
+/**
+ * Return whether the CPU supports an instruction set
+ */
+inline bool supported(const Isa isa)
+{
+#ifdef ODE_SIMD_X86
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return true;
+    case Isa::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case Isa::Avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::Avx512:
+        return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return Isa::Scalar == isa;
+#endif
+}
+
+/**
+ * Return the best supported instruction set, limited by the environment variable ODE_SIMD
+ */
+inline Isa detect()
+{
+    Isa limit{Isa::Avx512};
+    if (const char* env = std::getenv("ODE_SIMD"))
+    {
+        const std::string name{env};
+        limit = name == "scalar" ? Isa::Scalar : name == "sse2" ? Isa::Sse2 : name == "avx2" ? Isa::Avx2 : Isa::Avx512;
+    }
+    for (const Isa isa : {Isa::Avx512, Isa::Avx2, Isa::Sse2})
+    {
+        if (isa <= limit && supported(isa))
+        {
+            return isa;
+        }
+    }
+    return Isa::Scalar;
+}
+
+/**
+ * Return the kernels of an instruction set, which has to be supported
+ */
+template<typename T>
+const Kernels<T>& kernels(const Isa isa)
+{
+    static const Kernels<T> scalar{Isa::Scalar, Scalar<T>::dot, Scalar<T>::norm1, Scalar<T>::sumSquares, Scalar<T>::normInf, Scalar<T>::axpy, Scalar<T>::combine};
+#ifdef ODE_SIMD_X86
+    static const Kernels<T> sse2{Isa::Sse2, Sse2<T>::dot, Sse2<T>::norm1, Sse2<T>::sumSquares, Sse2<T>::normInf, Sse2<T>::axpy, Sse2<T>::combine};
+    static const Kernels<T> avx2{Isa::Avx2, Avx2<T>::dot, Avx2<T>::norm1, Avx2<T>::sumSquares, Avx2<T>::normInf, Avx2<T>::axpy, Avx2<T>::combine};
+    static const Kernels<T> avx512{Isa::Avx512, Avx512<T>::dot, Avx512<T>::norm1, Avx512<T>::sumSquares, Avx512<T>::normInf, Avx512<T>::axpy, Avx512<T>::combine};
+    switch (isa)
+    {
+    case Isa::Sse2:
+        return sse2;
+    case Isa::Avx2:
+        return avx2;
+    case Isa::Avx512:
+        return avx512;
+    default:
+        break;
+    }
+#endif
+    return scalar;
+}
+
+/**
+ * Return the kernels of the best supported instruction set
+ */
+template<typename T>
+const Kernels<T>& kernels()
+{
+    static const Kernels<T>& best{kernels<T>(detect())};
+    return best;
+}
+}
+}
@@ -1,17 +1,18 @@
 #pragma once
 
 #include "Function.h"
+#include "Workspace.h"
 
 namespace ode
 {
 /**
  * @brief OdeSolver class
  */
-template<typename T, typename Enable = void>
+template<typename T, size_t N = Dynamic, typename Enable = void>
 class Solver;
 
-template<typename T>
-class Solver<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+template<typename T, size_t N>
+class Solver<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type>
 {
 public:
     /**
@@ -21,7 +22,21 @@ public:
      * @param function   Ode function
      * @return calculated parameters
      */
-    virtual Vector<T> calc(T x, T dx, Function<T>& function) = 0;
+    virtual Vector<T, N> calc(T x, T dx, Function<T, N>& function)
+    {
+        Workspace<T, N> workspace{};
+        calc(x, dx, function, workspace);
+        return workspace.dy;
+    }
+
+    /**
+     * Calculate integration step without heap allocations
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Ode function
+     * @param workspace  Reusable buffers, the calculated parameters are stored in workspace.dy
+     */
+    virtual void calc(T x, T dx, Function<T, N>& function, Workspace<T, N>& workspace) = 0;
 
     /**
      * Calculate integration step
@@ -32,12 +47,14 @@ public:
      * @param function   Ode function
      * @return calculated parameters
      */
-    virtual Vector<T> calcRange(T x0, const Vector<T>& y0, T x, T dx, Function<T>& function)
+    virtual Vector<T, N> calcRange(T x0, const Vector<T, N>& y0, T x, T dx, Function<T, N>& function)
     {
-        Vector<T> y{y0};
+        Vector<T, N> y{y0};
+        Workspace<T, N> workspace{};
         for (T t{x0}; t <= x; t += dx)
         {
-            y += calc(t, dx, function);
+            calc(t, dx, function, workspace);
+            y += workspace.dy;
         }
         return y;
     }
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Function.h"
+#include <utility>
+
+namespace ode
+{
+/**
+ * @brief Static function interface
+ *
+ * The solvers' `step` methods are templated on the concrete function type, so
+ * calls of `derive` can be inlined into the stage loops. A function type for
+ * `step` either derives from `ode::Function` or provides the buffer based
+ * methods without virtual dispatch:
+ *
+ * - `void derive(T x, Vector<T, N>& y, Vector<T, N>& dydx)`
+ * - `void derive2(T x, Vector<T, N>& y, Vector<T, N>& dy, Vector<T, N>& dyd2x)` (VelocityVerlet only)
+ * - `void getParams(Vector<T, N>& y) const`
+ * - `void setParams(const Vector<T, N>& y)`
+ *
+ * If a class derived from `ode::Function` hides a buffer based method by
+ * overriding the returning overload only, the call falls back to the virtual
+ * method of the base class.
+ */
+template<typename F, typename V, typename T, typename = void>
+struct HasDerive : std::false_type
+{
+};
+
+template<typename F, typename V, typename T>
+struct HasDerive<F, V, T, decltype(std::declval<F&>().derive(std::declval<T>(), std::declval<V&>(), std::declval<V&>()))> : std::true_type
+{
+};
+
+template<typename F, typename V, typename T, typename = void>
+struct HasDerive2 : std::false_type
+{
+};
+
+template<typename F, typename V, typename T>
+struct HasDerive2<F, V, T, decltype(std::declval<F&>().derive2(std::declval<T>(), std::declval<V&>(), std::declval<V&>(), std::declval<V&>()))> : std::true_type
+{
+};
+
+template<typename F, typename V, typename = void>
+struct HasGetParams : std::false_type
+{
+};
+
+template<typename F, typename V>
+struct HasGetParams<F, V, decltype(std::declval<const F&>().getParams(std::declval<V&>()))> : std::true_type
+{
+};
+
+/**
+ * Calculate derivative into a caller provided buffer
+ */
+template<typename F, typename T, size_t N>
+void derive(F& function, const typename Vector<T, N>::value_type x, Vector<T, N>& y, Vector<T, N>& dydx)
+{
+    if constexpr (HasDerive<F, Vector<T, N>, T>::value)
+    {
+        function.derive(x, y, dydx);
+    }
+    else
+    {
+        static_cast<Function<T, N>&>(function).derive(x, y, dydx);
+    }
+}
+
+/**
+ * Calculate 2nd derivative into a caller provided buffer
+ */
+template<typename F, typename T, size_t N>
+void derive2(F& function, const typename Vector<T, N>::value_type x, Vector<T, N>& y, Vector<T, N>& dy, Vector<T, N>& dyd2x)
+{
+    if constexpr (HasDerive2<F, Vector<T, N>, T>::value)
+    {
+        function.derive2(x, y, dy, dyd2x);
+    }
+    else
+    {
+        static_cast<Function<T, N>&>(function).derive2(x, y, dy, dyd2x);
+    }
+}
+
+/**
+ * Copy the parameters into a caller provided buffer
+ */
+template<typename F, typename T, size_t N>
+void getParams(const F& function, Vector<T, N>& y)
+{
+    if constexpr (HasGetParams<F, Vector<T, N>>::value)
+    {
+        function.getParams(y);
+    }
+    else
+    {
+        static_cast<const Function<T, N>&>(function).getParams(y);
+    }
+}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Vector.h"
+#include "Workspace.h"
+#include <cmath>
+#include <cstddef>
+
+namespace ode
+{
+/**
+ * @brief SplitFunction class
+ *
+ * Function of a separable Hamiltonian system H(q, v) = v^2 / 2 + V(q), whose
+ * parameters split into positions q and velocities v of equal size with
+ * dq/dx = v and dv/dx = a(q). The symplectic solvers advance q and v
+ * separately and evaluate the accelerations only. A class implementing
+ * ode::Function as well can be integrated by all solvers.
+ */
+template<typename T, size_t N = Dynamic, typename Enable = void>
+class SplitFunction;
+
+template<typename T, size_t N>
+class SplitFunction<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    /**
+     * Copy the positions and velocities into caller provided buffers
+     */
+    virtual void getState(Vector<T, N>& q, Vector<T, N>& v) const = 0;
+
+    /**
+     * Callback of the solver with the new positions and velocities
+     */
+    virtual void setState(const Vector<T, N>& q, const Vector<T, N>& v) = 0;
+
+    /**
+     * Calculate accelerations
+     * @param x      Step variable
+     * @param q      Positions
+     * @param a      Calculated accelerations
+     */
+    virtual void accelerate(T x, const Vector<T, N>& q, Vector<T, N>& a) = 0;
+};
+
+/**
+ * @brief Coefficients of symplectic compositions
+ *
+ * A composition alternates drifts q += C[i] * dx * v and kicks
+ * v += D[i] * dx * a(q) for i < STAGES. A kick with zero coefficient is
+ * skipped, so a method evaluates the accelerations once per nonzero D.
+ */
+namespace composition
+{
+/**
+ * @brief Leapfrog, Stoermer Verlet in drift kick drift form
+ */
+struct Leapfrog
+{
+    static constexpr size_t STAGES{2U};
+    static constexpr size_t ORDER{2U};
+    static constexpr double C[STAGES]{1. / 2., 1. / 2.};
+    static constexpr double D[STAGES]{1., 0.};
+};
+
+/**
+ * @brief Yoshida 4th order, the triple jump of leapfrogs found by Forest and Ruth
+ */
+struct Yoshida4
+{
+    static constexpr size_t STAGES{4U};
+    static constexpr size_t ORDER{4U};
+    static constexpr double W1{1.3512071919596576}; //!< 1 / (2 - 2^(1/3))
+    static constexpr double W0{-1.7024143839193153}; //!< -2^(1/3) / (2 - 2^(1/3))
+    static constexpr double C[STAGES]{W1 / 2., (W0 + W1) / 2., (W0 + W1) / 2., W1 / 2.};
+    static constexpr double D[STAGES]{W1, W0, W1, 0.};
+};
+}
+
+/**
+ * @brief Symplectic class
+ *
+ * Symplectic composition method of a split function, see the coefficients
+ * in namespace composition. The energy error of a symplectic method stays
+ * bounded over long integrations instead of drifting, so periodic orbits
+ * remain closed at much larger steps than with Runge Kutta methods.
+ */
+template<typename T, typename Coefficients, size_t N = Dynamic>
+class Symplectic
+{
+public:
+    Symplectic() = default;
+
+    /**
+     * Calculate integration step
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Split function
+     */
+    void calc(T x, T dx, SplitFunction<T, N>& function)
+    {
+        step(x, dx, function, m_workspace);
+    }
+
+    /**
+     * Calculate integration step without virtual dispatch
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Function providing the methods of SplitFunction
+     * @param workspace  Reusable buffers, the positions are kept in workspace.y, the velocities in workspace.yx
+     */
+    template<typename F>
+    void step(T x, T dx, F& function, Workspace<T, N>& workspace)
+    {
+        function.getState(workspace.y, workspace.yx);
+        workspace.resize(0U, workspace.y.size());
+        Vector<T, N>& q{workspace.y};
+        Vector<T, N>& v{workspace.yx};
+        Vector<T, N>& a{workspace.dydx};
+        const size_t size{q.size()};
+
+        T t{x};
+        for (size_t s{0U}; s < Coefficients::STAGES; ++s)
+        {
+            const T drift{static_cast<T>(Coefficients::C[s]) * dx};
+            for (size_t i{0U}; i < size; ++i)
+            {
+                q[i] += drift * v[i];
+            }
+            t += drift;
+            if (Coefficients::D[s] != 0.)
+            {
+                const T kick{static_cast<T>(Coefficients::D[s]) * dx};
+                function.accelerate(t, q, a);
+                for (size_t i{0U}; i < size; ++i)
+                {
+                    v[i] += kick * a[i];
+                }
+            }
+        }
+        function.setState(q, v);
+    }
+
+private:
+    Workspace<T, N> m_workspace{};
+};
+
+/**
+ * @brief Leapfrog solver, 2nd order with one evaluation per step
+ */
+template<typename T, size_t N = Dynamic>
+using Leapfrog = Symplectic<T, composition::Leapfrog, N>;
+
+/**
+ * @brief Yoshida solver, 4th order with three evaluations per step
+ */
+template<typename T, size_t N = Dynamic>
+using Yoshida4 = Symplectic<T, composition::Yoshida4, N>;
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ode
+{
+/**
+ * @brief TextReader class
+ *
+ * Reads whitespace separated numbers and words from a memory mapped text
+ * file with std::from_chars. Large blocks of numbers are parsed in parallel:
+ * the text is split into chunks at whitespace, the numbers of each chunk are
+ * counted and then parsed into their final place.
+ */
+template<typename T, typename Enable = void>
+class TextReader;
+
+template<typename T>
+class TextReader<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    TextReader() = default;
+
+    /**
+     * Map file
+     * @return false if the file can't be read
+     */
+    bool open(const std::string& filename)
+    {
+        m_position = 0U;
+        return m_file.open(filename);
+    }
+
+    void close()
+    {
+        m_file.close();
+        m_position = 0U;
+    }
+
+    /**
+     * Number of bytes not read yet, an upper bound of the numbers left in the file
+     */
+    [[nodiscard]] size_t remaining() const
+    {
+        return m_file.size() - m_position;
+    }
+
+    /**
+     * Read the next number
+     * @return false if the next word isn't a number of type U
+     */
+    template<typename U>
+    bool read(U& value)
+    {
+        static_assert(std::is_arithmetic<U>::value, "Numbers must be arithmetic");
+        const char* first{skip(m_file.data() + m_position)};
+        const char* last{word(first)};
+        m_position = static_cast<size_t>(last - m_file.data());
+        return parse(first, last, value);
+    }
+
+    /**
+     * Read the next word
+     * @return false at the end of the file
+     */
+    bool read(std::string& text)
+    {
+        const char* first{skip(m_file.data() + m_position)};
+        const char* last{word(first)};
+        m_position = static_cast<size_t>(last - m_file.data());
+        text.assign(first, last);
+        return first != last;
+    }
+
+    /**
+     * Read the next count numbers
+     * @param values     Array of count values
+     * @param count      Number of values
+     * @param pool       Threads parsing the chunks of large blocks, null to parse on the calling thread
+     * @return false if the file holds less numbers or an invalid one
+     */
+    bool read(T* values, const size_t count, ThreadPool* pool = nullptr)
+    {
+        const char* begin{m_file.data() + m_position};
+        const char* end{m_file.data() + m_file.size()};
+        const size_t threads{pool != nullptr ? pool->size() : 1U};
+        if (threads == 1U || count < PARALLEL)
+        {
+            for (size_t i{0U}; i < count; ++i)
+            {
+                if (!read(values[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Chunks start at whitespace, so no number is split
+        const size_t chunks{threads * 4U};
+        std::vector<const char*> bounds(chunks + 1U, end);
+        bounds[0U] = begin;
+        for (size_t c{1U}; c < chunks; ++c)
+        {
+            const char* bound{bounds[c - 1U] + (end - bounds[c - 1U]) / static_cast<std::ptrdiff_t>(chunks + 1U - c)};
+            bounds[c] = word(bound);
+        }
+
+        // Count the numbers of each chunk, the prefix sum is the index of its first number
+        std::vector<size_t> offsets(chunks + 1U, 0U);
+        pool->parallelFor(chunks, 1U, [&](size_t, size_t first, size_t last) {
+            for (size_t c{first}; c < last; ++c)
+            {
+                size_t words{0U};
+                for (const char* it{skip(bounds[c], bounds[c + 1U])}; it != bounds[c + 1U]; it = skip(word(it, bounds[c + 1U]), bounds[c + 1U]))
+                {
+                    ++words;
+                }
+                offsets[c + 1U] = words;
+            }
+        });
+        for (size_t c{0U}; c < chunks; ++c)
+        {
+            offsets[c + 1U] += offsets[c];
+        }
+        if (offsets[chunks] < count)
+        {
+            m_position = m_file.size();
+            return false;
+        }
+
+        // Parse the numbers up to count, the chunk of the last one sets the read position
+        std::atomic<bool> valid{true};
+        pool->parallelFor(chunks, 1U, [&](size_t, size_t first, size_t last) {
+            for (size_t c{first}; c < last; ++c)
+            {
+                size_t i{offsets[c]};
+                const char* it{skip(bounds[c], bounds[c + 1U])};
+                while (i < count && it != bounds[c + 1U])
+                {
+                    const char* next{word(it, bounds[c + 1U])};
+                    if (!parse(it, next, values[i]))
+                    {
+                        valid.store(false, std::memory_order_relaxed);
+                    }
+                    if (++i == count)
+                    {
+                        m_position = static_cast<size_t>(next - m_file.data());
+                    }
+                    it = skip(next, bounds[c + 1U]);
+                }
+            }
+        });
+        return valid.load();
+    }
+
+private:
+    //! Minimum number of values parsed in parallel
+    static constexpr size_t PARALLEL{1U << 16U};
+
+    static bool space(const char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    /**
+     * Return the first character of the next word
+     */
+    const char* skip(const char* it) const
+    {
+        return skip(it, m_file.data() + m_file.size());
+    }
+
+    static const char* skip(const char* it, const char* end)
+    {
+        while (it != end && space(*it))
+        {
+            ++it;
+        }
+        return it;
+    }
+
+    /**
+     * Return the end of the word at it
+     */
+    const char* word(const char* it) const
+    {
+        return word(it, m_file.data() + m_file.size());
+    }
+
+    static const char* word(const char* it, const char* end)
+    {
+        while (it != end && !space(*it))
+        {
+            ++it;
+        }
+        return it;
+    }
+
+    /**
+     * Parse the complete word [first, last) as number
+     */
+    template<typename U>
+    static bool parse(const char* first, const char* last, U& value)
+    {
+        if (first != last && *first == '+')
+        {
+            ++first;
+        }
+        const auto result = std::from_chars(first, last, value);
+        return first != last && result.ec == std::errc{} && result.ptr == last;
+    }
+
+    MappedFile m_file{};
+    size_t m_position{0U}; //!< Read position
+};
+}
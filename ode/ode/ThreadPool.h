@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ode
+{
+/**
+ * @brief ThreadPool class
+ *
+ * Fixed number of worker threads executing one task at a time. The calling
+ * thread takes part as thread 0, so a pool of a single thread runs tasks
+ * inline. Tasks are passed by reference and never copied or allocated.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Create pool
+     * @param threads    Number of threads including the calling thread, zero for all cores
+     */
+    explicit ThreadPool(size_t threads = 0U)
+    {
+        if (threads == 0U)
+        {
+            threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+        m_workers.reserve(threads - 1U);
+        for (size_t i{1U}; i < threads; ++i)
+        {
+            m_workers.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    /**
+     * Number of threads including the calling thread
+     */
+    [[nodiscard]] size_t size() const
+    {
+        return m_workers.size() + 1U;
+    }
+
+    /**
+     * Call task(thread) on every thread and wait for completion
+     */
+    template<typename F>
+    void run(F&& task)
+    {
+        if (m_workers.empty())
+        {
+            task(size_t{0U});
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_task = &task;
+            m_invoke = [](void* function, size_t thread) { (*static_cast<std::remove_reference_t<F>*>(function))(thread); };
+            m_pending = m_workers.size();
+            ++m_generation;
+        }
+        m_start.notify_all();
+        task(size_t{0U});
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_done.wait(lock, [this]() { return m_pending == 0U; });
+    }
+
+    /**
+     * Call body(thread, begin, end) for chunks of the range [0, count) on all threads
+     * @param count      Number of items
+     * @param grain      Number of items per chunk, chunks are scheduled dynamically
+     * @param body       Chunk function
+     */
+    template<typename F>
+    void parallelFor(const size_t count, const size_t grain, F&& body)
+    {
+        const size_t chunk{std::max<size_t>(grain, 1U)};
+        std::atomic<size_t> next{0U};
+        run([&](size_t thread) {
+            for (size_t begin{next.fetch_add(chunk)}; begin < count; begin = next.fetch_add(chunk))
+            {
+                body(thread, begin, std::min(begin + chunk, count));
+            }
+        });
+    }
+
+private:
+    void work(const size_t thread)
+    {
+        size_t generation{0U};
+        for (;;)
+        {
+            void* task{nullptr};
+            void (*invoke)(void*, size_t){nullptr};
+            {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_start.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+                if (m_stop)
+                {
+                    return;
+                }
+                generation = m_generation;
+                task = m_task;
+                invoke = m_invoke;
+            }
+            invoke(task, thread);
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                --m_pending;
+            }
+            m_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_workers{}; //!< Worker threads
+    std::mutex m_mutex{};
+    std::condition_variable m_start{}; //!< Signals a new task or stop
+    std::condition_variable m_done{}; //!< Signals completion of a worker
+    void* m_task{nullptr}; //!< Current task
+    void (*m_invoke)(void*, size_t){nullptr}; //!< Calls the current task
+    size_t m_generation{0U}; //!< Number of started tasks
+    size_t m_pending{0U}; //!< Number of workers still running the current task
+    bool m_stop{false}; //!< Workers terminate
+};
+}
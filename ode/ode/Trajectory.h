@@ -0,0 +1,298 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ode
+{
+/**
+ * @brief Binary trajectory file format
+ *
+ * A file consists of the header, fixed size frames and the frame index. Each
+ * frame holds its variable as double followed by particles * dimension values
+ * of the given precision. The index holds the file offset of each frame, the
+ * header is completed with the number of frames and the index offset when the
+ * file is closed. Files of an interrupted simulation have no index, their
+ * frames are found by their fixed size. All values are in native byte order.
+ */
+namespace trajectory
+{
+//! File signature
+static constexpr char MAGIC[8]{'O', 'D', 'E', 'T', 'R', 'J', '\0', '\0'};
+//! Format version
+static constexpr uint32_t VERSION{1U};
+
+/**
+ * @brief File header
+ */
+struct Header
+{
+    char magic[8]{}; //!< File signature MAGIC
+    uint32_t version{VERSION}; //!< Format version
+    uint32_t precision{0U}; //!< Bytes per value, 4 or 8
+    uint64_t particles{0U}; //!< Number of particles
+    uint64_t dimension{0U}; //!< Values per particle
+    double timeStep{0.}; //!< Variable step of the simulation
+    uint64_t frames{0U}; //!< Number of frames, zero until the file is closed
+    uint64_t index{0U}; //!< File offset of the frame index, zero until the file is closed
+};
+
+static_assert(sizeof(Header) == 56U, "Trajectory header must not have padding");
+
+/**
+ * Return the size of a frame in bytes
+ */
+inline uint64_t frameSize(const Header& header)
+{
+    return sizeof(double) + header.particles * header.dimension * header.precision;
+}
+}
+
+/**
+ * @brief TrajectoryWriter class
+ *
+ * Writes frames of values in the binary trajectory format.
+ */
+template<typename T, typename Enable = void>
+class TrajectoryWriter;
+
+template<typename T>
+class TrajectoryWriter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    TrajectoryWriter() = default;
+
+    TrajectoryWriter(TrajectoryWriter&&) noexcept = default;
+    TrajectoryWriter& operator=(TrajectoryWriter&&) noexcept = default;
+
+    ~TrajectoryWriter()
+    {
+        close();
+    }
+
+    /**
+     * Create file
+     * @param filename   File name
+     * @param particles  Number of particles
+     * @param dimension  Values per particle
+     * @param timeStep   Variable step of the simulation
+     * @return false if the file can't be created
+     */
+    bool open(const std::string& filename, const size_t particles, const size_t dimension, const double timeStep)
+    {
+        close();
+        m_header = trajectory::Header{};
+        std::memcpy(m_header.magic, trajectory::MAGIC, sizeof(m_header.magic));
+        m_header.precision = sizeof(T);
+        m_header.particles = particles;
+        m_header.dimension = dimension;
+        m_header.timeStep = timeStep;
+        m_offsets.clear();
+        m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+        return m_file.good();
+    }
+
+    [[nodiscard]] bool isOpen() const
+    {
+        return m_file.is_open();
+    }
+
+    /**
+     * Append a frame
+     * @param x          Variable
+     * @param values     particles * dimension values
+     */
+    void write(const double x, const T* values)
+    {
+        m_offsets.push_back(sizeof(trajectory::Header) + m_offsets.size() * trajectory::frameSize(m_header));
+        m_file.write(reinterpret_cast<const char*>(&x), sizeof(x));
+        m_file.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(m_header.particles * m_header.dimension * sizeof(T)));
+    }
+
+    /**
+     * Write the frame index, complete the header and close the file
+     */
+    void close()
+    {
+        if (!m_file.is_open())
+        {
+            return;
+        }
+        m_header.frames = m_offsets.size();
+        m_header.index = sizeof(trajectory::Header) + m_offsets.size() * trajectory::frameSize(m_header);
+        m_file.write(reinterpret_cast<const char*>(m_offsets.data()), static_cast<std::streamsize>(m_offsets.size() * sizeof(uint64_t)));
+        m_file.seekp(0);
+        m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+        m_file.close();
+    }
+
+private:
+    std::ofstream m_file{};
+    trajectory::Header m_header{};
+    std::vector<uint64_t> m_offsets{}; //!< File offset of each frame
+};
+
+/**
+ * @brief TrajectoryReader class
+ *
+ * Random access to the frames of a binary trajectory file, which is mapped
+ * into memory. Frames are returned as pointers into the mapping without
+ * copies.
+ */
+template<typename T, typename Enable = void>
+class TrajectoryReader;
+
+template<typename T>
+class TrajectoryReader<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    TrajectoryReader() = default;
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    ~TrajectoryReader()
+    {
+        close();
+    }
+
+    /**
+     * Map file
+     * @return false if the file can't be read, isn't a trajectory or has another precision than T
+     */
+    bool open(const std::string& filename)
+    {
+        close();
+        if (!m_file.open(filename) || m_file.size() < sizeof(trajectory::Header))
+        {
+            close();
+            return false;
+        }
+        m_data = m_file.data();
+        m_size = m_file.size();
+        std::memcpy(&m_header, m_data, sizeof(m_header));
+        if (std::memcmp(m_header.magic, trajectory::MAGIC, sizeof(m_header.magic)) != 0 || m_header.version != trajectory::VERSION || m_header.precision != sizeof(T))
+        {
+            close();
+            return false;
+        }
+
+        // A frame must fit into the file, which also keeps frameSize from overflowing
+        const uint64_t available{m_size - sizeof(trajectory::Header)};
+        if (m_header.dimension != 0U && m_header.particles > available / m_header.precision / m_header.dimension)
+        {
+            close();
+            return false;
+        }
+
+        // Files without index contain the frames written before an interruption, a corrupt index is ignored
+        const uint64_t frameSize{trajectory::frameSize(m_header)};
+        if (validIndex(frameSize))
+        {
+            m_index = m_data + m_header.index;
+        }
+        else
+        {
+            const bool before{m_header.index >= sizeof(trajectory::Header) && m_header.index <= m_size};
+            m_header.frames = ((before ? m_header.index : m_size) - sizeof(trajectory::Header)) / frameSize;
+            m_index = nullptr;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        m_file.close();
+        m_data = nullptr;
+        m_size = 0U;
+        m_header = trajectory::Header{};
+        m_index = nullptr;
+    }
+
+    [[nodiscard]] size_t frames() const
+    {
+        return m_header.frames;
+    }
+
+    [[nodiscard]] size_t particles() const
+    {
+        return m_header.particles;
+    }
+
+    [[nodiscard]] size_t dimension() const
+    {
+        return m_header.dimension;
+    }
+
+    [[nodiscard]] double timeStep() const
+    {
+        return m_header.timeStep;
+    }
+
+    /**
+     * Return the variable of frame k < frames()
+     */
+    [[nodiscard]] double variable(const size_t k) const
+    {
+        double x{0.};
+        std::memcpy(&x, m_data + offset(k), sizeof(x));
+        return x;
+    }
+
+    /**
+     * Return the particles * dimension values of frame k < frames()
+     */
+    [[nodiscard]] const T* frame(const size_t k) const
+    {
+        return reinterpret_cast<const T*>(m_data + offset(k) + sizeof(double));
+    }
+
+private:
+    /**
+     * Return true if the index lies behind the frames and each offset points to a frame within the file
+     */
+    [[nodiscard]] bool validIndex(const uint64_t frameSize) const
+    {
+        const uint64_t index{m_header.index};
+        if (index < sizeof(trajectory::Header) || index > m_size || m_header.frames > (m_size - index) / sizeof(uint64_t) ||
+            m_header.frames > (index - sizeof(trajectory::Header)) / frameSize)
+        {
+            return false;
+        }
+        for (uint64_t k{0U}; k < m_header.frames; ++k)
+        {
+            uint64_t offset{0U};
+            std::memcpy(&offset, m_data + index + k * sizeof(uint64_t), sizeof(offset));
+            if (offset < sizeof(trajectory::Header) || offset > index - frameSize)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] uint64_t offset(const size_t k) const
+    {
+        if (m_index != nullptr)
+        {
+            uint64_t offset{0U};
+            std::memcpy(&offset, m_index + k * sizeof(uint64_t), sizeof(offset));
+            return offset;
+        }
+        return sizeof(trajectory::Header) + k * trajectory::frameSize(m_header);
+    }
+
+    MappedFile m_file{};
+    const char* m_data{nullptr}; //!< Mapped file
+    size_t m_size{0U}; //!< File size
+    const char* m_index{nullptr}; //!< Frame index, null for files without index
+    trajectory::Header m_header{};
+};
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "Expression.h"
+#include "Simd.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <limits>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace ode
@@ -19,145 +24,61 @@ bool equal(const T a, const T b, const T e = std::numeric_limits<T>::epsilon())
 }
 
 /**
- * @brief Vector class
+ * @brief Size of a vector which is known at run time only
  */
-template<typename T, typename Enable = void>
-class Vector;
+static constexpr size_t Dynamic{0U};
 
-template<typename T>
-class Vector<T, typename std::enable_if<std::is_floating_point<T>::value>::type> : public std::vector<T>
+/**
+ * @brief Vector operations
+ *
+ * Operations shared by the dynamic and the fixed size vector. Loops over a
+ * fixed size vector are unrolled at compile time, reductions of large dynamic
+ * vectors use the vectorized kernels of Simd.h.
+ */
+template<typename V, typename T>
+class VectorOperations : public Expression<V>
 {
-    using Base = std::vector<T>;
-
 public:
-    Vector() = default;
-    Vector(const size_t size)
-        : Base(size)
-    {
-    }
-
-    Vector(std::initializer_list<T> rhs)
-        : Base{rhs}
-    {
-    }
-
-    Vector operator+() const
-    {
-        return Vector(*this);
-    }
-
-    Vector operator-() const
-    {
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] * -1.F;
-        }
-        return result;
-    }
-
-    Vector operator+(T x) const
+    V& operator+=(T x)
     {
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] + x;
-        }
-        return result;
+        return apply([this, x](const size_t i) { derived()[i] += x; });
     }
 
-    Vector operator-(T x) const
+    V& operator-=(T x)
     {
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] - x;
-        }
-        return result;
+        return apply([this, x](const size_t i) { derived()[i] -= x; });
     }
 
-    Vector operator*(T x) const
+    V& operator*=(T x)
     {
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] * x;
-        }
-        return result;
+        return apply([this, x](const size_t i) { derived()[i] *= x; });
     }
 
-    Vector operator/(T x) const
+    V& operator/=(T x)
     {
         assert(!equal(x, T{0}));
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] / x;
-        }
-        return result;
+        return apply([this, x](const size_t i) { derived()[i] /= x; });
     }
 
-    Vector operator+(const Vector& vec) const
+    template<typename E>
+    V& operator+=(const Expression<E>& expression)
     {
-        assert(Base::size() == vec.size());
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] + vec[i];
-        }
-        return result;
+        const E& e{expression.self()};
+        assert(derived().size() == e.size());
+        return apply([this, &e](const size_t i) { derived()[i] += e[i]; });
     }
 
-    Vector operator-(const Vector& vec) const
+    template<typename E>
+    V& operator-=(const Expression<E>& expression)
     {
-        assert(Base::size() == vec.size());
-        Vector result(Base::size());
-        for (size_t i{0U}; i < Base::size(); ++i)
-        {
-            result[i] = (*this)[i] - vec[i];
-        }
-        return result;
-    }
-
-    Vector& operator+=(T x)
-    {
-        *this = *this + x;
-        return *this;
-    }
-
-    Vector& operator-=(T x)
-    {
-        *this = *this - x;
-        return *this;
-    }
-
-    Vector& operator*=(T x)
-    {
-        *this = *this * x;
-        return *this;
-    }
-
-    Vector& operator/=(T x)
-    {
-        *this = *this / x;
-        return *this;
-    }
-
-    Vector& operator+=(const Vector& vec)
-    {
-        *this = *this + vec;
-        return *this;
-    }
-
-    Vector& operator-=(const Vector& vec)
-    {
-        *this = *this - vec;
-        return *this;
+        const E& e{expression.self()};
+        assert(derived().size() == e.size());
+        return apply([this, &e](const size_t i) { derived()[i] -= e[i]; });
     }
 
     [[nodiscard]] bool isUnity() const
     {
-        for (const auto& value : *this)
+        for (const auto& value : derived())
         {
             if (!equal(value, T{1}))
             {
@@ -169,7 +90,11 @@ public:
 
     [[nodiscard]] bool isZero() const
     {
-        for (const auto& value : *this)
+        if (isLarge())
+        {
+            return simd::kernels<T>().normInf(derived().data(), derived().size()) <= std::numeric_limits<T>::epsilon();
+        }
+        for (const auto& value : derived())
         {
             if (!equal(value, T{0}))
             {
@@ -179,13 +104,24 @@ public:
         return true;
     }
 
-    Vector& makeZero()
+    V& makeZero()
+    {
+        std::fill(derived().begin(), derived().end(), T{0});
+        return derived();
+    }
+
+    /**
+     * Add a scaled vector, y += a * x
+     */
+    V& axpy(T a, const V& x)
     {
-        for (auto& value : *this)
+        assert(derived().size() == x.size());
+        if (isLarge())
         {
-            value = T{0};
+            simd::kernels<T>().axpy(a, x.data(), derived().data(), derived().size());
+            return derived();
         }
-        return *this;
+        return apply([this, a, &x](const size_t i) { derived()[i] += a * x[i]; });
     }
 
     [[nodiscard]] T norm(const uint32_t p) const
@@ -194,10 +130,15 @@ public:
         {
             return T{0};
         }
+        else if (isLarge() && (1U == p || 2U == p))
+        {
+            const auto& kernels = simd::kernels<T>();
+            return 1U == p ? kernels.norm1(derived().data(), derived().size()) : std::sqrt(kernels.sumSquares(derived().data(), derived().size()));
+        }
         else if (1U == p)
         {
             T res = T{0};
-            for (const auto& value : *this)
+            for (const auto& value : derived())
             {
                 res += std::abs(value);
             }
@@ -206,7 +147,7 @@ public:
         else if (2U == p)
         {
             T res = T{0};
-            for (const auto& value : *this)
+            for (const auto& value : derived())
             {
                 res += value * value;
             }
@@ -215,15 +156,29 @@ public:
         else
         {
             T res = T{0};
-            for (const auto& value : *this)
+            for (const auto& value : derived())
             {
-                res += std::pow(std::abs(value), static_cast<T>(p));
+                res += power(std::abs(value), p);
             }
             return std::pow(res, T{T{1} / p});
         }
         return T{0};
     }
 
+    [[nodiscard]] T normInf() const
+    {
+        if (isLarge())
+        {
+            return simd::kernels<T>().normInf(derived().data(), derived().size());
+        }
+        T res = T{0};
+        for (const auto& value : derived())
+        {
+            res = std::max(res, std::abs(value));
+        }
+        return res;
+    }
+
     [[nodiscard]] T length() const
     {
         return norm(2);
@@ -234,22 +189,210 @@ public:
         operator/=(length());
     }
 
-    void normalize(const Vector& vec)
+    void normalize(const V& vec)
     {
         assert(vec.isZero());
         operator/=(T{1} / vec.length());
     }
 
-    [[nodiscard]] T dot(const Vector& vec) const
+    [[nodiscard]] T dot(const V& vec) const
     {
-        assert(Base::size() == vec.size());
+        assert(derived().size() == vec.size());
+        if (isLarge())
+        {
+            return simd::kernels<T>().dot(derived().data(), vec.data(), derived().size());
+        }
         T result{};
-        for (size_t i{0U}; i < Base::size(); ++i)
+        for (size_t i{0U}; i < derived().size(); ++i)
         {
-            result += (*this)[i] * vec[i];
+            result += derived()[i] * vec[i];
         }
         return result;
     }
 
+protected:
+    V& derived()
+    {
+        return static_cast<V&>(*this);
+    }
+
+    const V& derived() const
+    {
+        return static_cast<const V&>(*this);
+    }
+
+    /**
+     * Call f(i) for each element index i
+     */
+    template<typename F>
+    V& apply(F f)
+    {
+        if constexpr (V::Extent != Dynamic)
+        {
+            unroll(f, std::make_index_sequence<V::Extent>{});
+        }
+        else
+        {
+            for (size_t i{0U}; i < derived().size(); ++i)
+            {
+                f(i);
+            }
+        }
+        return derived();
+    }
+
+    /**
+     * Return whether the vector is dispatched to the vectorized kernels
+     */
+    bool isLarge() const
+    {
+        return V::Extent == Dynamic && derived().size() >= simd::THRESHOLD;
+    }
+
+private:
+    static T power(T base, uint32_t p)
+    {
+        T result{1};
+        while (p > 0U)
+        {
+            if (p & 1U)
+            {
+                result *= base;
+            }
+            base *= base;
+            p >>= 1U;
+        }
+        return result;
+    }
+
+    template<typename F, size_t... I>
+    static void unroll(F& f, std::index_sequence<I...>)
+    {
+        (f(I), ...);
+    }
+};
+
+/**
+ * @brief Vector class
+ *
+ * `Vector<T>` holds a number of elements known at run time only on the heap,
+ * `Vector<T, N>` holds N elements on the stack.
+ */
+template<typename T, size_t N = Dynamic, typename Enable = void>
+class Vector;
+
+template<typename T>
+class Vector<T, Dynamic, typename std::enable_if<std::is_floating_point<T>::value>::type>
+    : public std::vector<T>
+    , public VectorOperations<Vector<T>, T>
+{
+    using Base = std::vector<T>;
+
+public:
+    static constexpr size_t Extent{Dynamic};
+
+    Vector() = default;
+    Vector(const size_t size)
+        : Base(size)
+    {
+    }
+
+    Vector(std::initializer_list<T> rhs)
+        : Base{rhs}
+    {
+    }
+
+    template<typename E>
+    Vector(const Expression<E>& expression)
+        : Base(expression.self().size())
+    {
+        evaluate(expression.self());
+    }
+
+    template<typename E>
+    Vector& operator=(const Expression<E>& expression)
+    {
+        const E& e{expression.self()};
+        if (Base::size() != e.size())
+        {
+            Base::resize(e.size());
+        }
+        evaluate(e);
+        return *this;
+    }
+
+private:
+    template<typename E>
+    void evaluate(const E& e)
+    {
+        this->apply([this, &e](const size_t i) { (*this)[i] = e[i]; });
+    }
+};
+
+template<typename T, size_t N>
+class Vector<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type>
+    : public std::array<T, N>
+    , public VectorOperations<Vector<T, N>, T>
+{
+    using Base = std::array<T, N>;
+
+public:
+    static constexpr size_t Extent{N};
+
+    Vector()
+        : Base{}
+    {
+    }
+
+    /**
+     * Create vector, the size has to match N
+     */
+    Vector([[maybe_unused]] const size_t size)
+        : Base{}
+    {
+        assert(N == size);
+    }
+
+    Vector(std::initializer_list<T> rhs)
+        : Base{}
+    {
+        assert(rhs.size() <= N);
+        std::copy(rhs.begin(), rhs.end(), Base::begin());
+    }
+
+    template<typename E>
+    Vector(const Expression<E>& expression)
+    {
+        evaluate(expression.self());
+    }
+
+    template<typename E>
+    Vector& operator=(const Expression<E>& expression)
+    {
+        evaluate(expression.self());
+        return *this;
+    }
+
+    /**
+     * Resize vector, the size has to match N
+     */
+    void resize([[maybe_unused]] const size_t size)
+    {
+        assert(N == size);
+    }
+
+private:
+    template<typename E>
+    void evaluate(const E& e)
+    {
+        assert(N == e.size());
+        this->apply([this, &e](const size_t i) { (*this)[i] = e[i]; });
+    }
+};
+
+template<typename T, size_t N, typename Enable>
+struct Operand<Vector<T, N, Enable>>
+{
+    using Type = const Vector<T, N, Enable>&;
 };
 }
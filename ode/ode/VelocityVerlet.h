@@ -1,25 +1,97 @@
 #pragma once
 
 #include "Solver.h"
+#include "StaticFunction.h"
 
 namespace ode
 {
 /**
  * @brief VelocityVerlet class
  */
-template<typename T>
-class VelocityVerlet : public Solver<T>
+template<typename T, size_t N = Dynamic>
+class VelocityVerlet : public Solver<T, N>
 {
 public:
     VelocityVerlet() = default;
 
-    Vector<T> calc(T x, T dx, Function<T>& function) final
+    using Solver<T, N>::calc;
+
+    void calc(T x, T dx, Function<T, N>& function, Workspace<T, N>& workspace) final
+    {
+        step(x, dx, function, workspace);
+    }
+
+    /**
+     * Calculate integration step without virtual dispatch
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Ode function, see StaticFunction.h
+     * @param workspace  Reusable buffers, the calculated parameters are stored in workspace.dy
+     */
+    template<typename F>
+    void step(T x, T dx, F& function, Workspace<T, N>& workspace)
     {
-        Vector<T> y{function.getParams()};
-        Vector<T> dydx{function.derive(x + dx, y)};
-        Vector<T> dyd2x{function.derive2(x + dx, y, dydx)};
-        function.setParams(dyd2x);
-        return dyd2x;
+        ode::getParams(function, workspace.y);
+        workspace.resize(0U, workspace.y.size());
+
+        ode::derive(function, x + dx, workspace.y, workspace.dydx);
+        ode::derive2(function, x + dx, workspace.y, workspace.dydx, workspace.dy);
+        function.setParams(workspace.dy);
+    }
+
+    /**
+     * Calculate integration step of particles in structure of arrays layout in place
+     *
+     * The particles provide `size()`, `position(k)`, `velocity(k)` and
+     * `force(k)` returning the contiguous values of axis k < 3 and `mass()`.
+     * The forces must be those of the current positions.
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param particles  Particles
+     * @param forces     Calculates the forces of the particles at a variable as forces(x)
+     */
+    template<typename P, typename F>
+    void advance(T x, T dx, P& particles, F&& forces)
+    {
+        advance(x, dx, particles, forces, [](size_t, size_t, T) {});
+    }
+
+    /**
+     * Calculate integration step of particles and observe the new velocities
+     * @param observe    Called as observe(k, i, velocity) with the final velocity of axis k of particle i,
+     *                   so observables like the kinetic energy need no extra pass over the particles
+     */
+    template<typename P, typename F, typename O>
+    void advance(T x, T dx, P& particles, F&& forces, O&& observe)
+    {
+        const size_t size{particles.size()};
+        const T* mass{particles.mass()};
+        const T half{T{0.5} * dx};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            T* position{particles.position(k)};
+            T* velocity{particles.velocity(k)};
+            const T* force{particles.force(k)};
+            for (size_t i{0U}; i < size; ++i)
+            {
+                // v += F / m * dt / 2, r += v * dt
+                velocity[i] += half * force[i] / mass[i];
+                position[i] += velocity[i] * dx;
+            }
+        }
+
+        forces(x + dx);
+
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            T* velocity{particles.velocity(k)};
+            const T* force{particles.force(k)};
+            for (size_t i{0U}; i < size; ++i)
+            {
+                velocity[i] += half * force[i] / mass[i];
+                observe(k, i, velocity[i]);
+            }
+        }
     }
 };
 }
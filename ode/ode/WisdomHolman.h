@@ -0,0 +1,295 @@
+#pragma once
+
+#include "Symplectic.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace ode
+{
+/**
+ * Advance a body on its Kepler orbit around a fixed center
+ *
+ * Universal variable formulation with Stumpff functions, valid for elliptic,
+ * parabolic and hyperbolic orbits. The universal anomaly is solved by Newton
+ * iterations in double precision.
+ * @param mu         Gravitational parameter G * M of the center
+ * @param r          Position relative to the center, updated
+ * @param v          Velocity relative to the center, updated
+ * @param dt         Time step
+ */
+template<typename T>
+void kepler(const double mu, T* r, T* v, const double dt)
+{
+    const double r0[3]{r[0], r[1], r[2]};
+    const double v0[3]{v[0], v[1], v[2]};
+    const double distance{std::sqrt(r0[0] * r0[0] + r0[1] * r0[1] + r0[2] * r0[2])};
+    if (distance <= 0. || mu <= 0. || dt == 0.)
+    {
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            r[k] = static_cast<T>(r0[k] + v0[k] * dt);
+        }
+        return;
+    }
+    const double root{std::sqrt(mu)};
+    const double radial{(r0[0] * v0[0] + r0[1] * v0[1] + r0[2] * v0[2]) / root};
+    const double alpha{2. / distance - (v0[0] * v0[0] + v0[1] * v0[1] + v0[2] * v0[2]) / mu}; //!< Reciprocal semi major axis
+
+    // Stumpff functions C(z) and S(z)
+    auto stumpff = [](const double z, double& c, double& s) {
+        if (z > 1e-6)
+        {
+            const double w{std::sqrt(z)};
+            c = (1. - std::cos(w)) / z;
+            s = (w - std::sin(w)) / (z * w);
+        }
+        else if (z < -1e-6)
+        {
+            const double w{std::sqrt(-z)};
+            c = (std::cosh(w) - 1.) / -z;
+            s = (std::sinh(w) - w) / (-z * w);
+        }
+        else
+        {
+            c = 1. / 2. - z / 24. + z * z / 720.;
+            s = 1. / 6. - z / 120. + z * z / 5040.;
+        }
+    };
+
+    // Newton iterations of the universal Kepler equation, the derivative is the new distance
+    double chi{alpha > 0. ? root * dt * alpha : root * dt / distance};
+    double c{0.};
+    double s{0.};
+    for (size_t iteration{0U}; iteration < 50U; ++iteration)
+    {
+        const double z{alpha * chi * chi};
+        stumpff(z, c, s);
+        const double chi2{chi * chi};
+        const double f{radial * chi2 * c + (1. - alpha * distance) * chi2 * chi * s + distance * chi - root * dt};
+        const double df{radial * chi * (1. - z * s) + (1. - alpha * distance) * chi2 * c + distance};
+        const double delta{f / df};
+        chi -= delta;
+        if (std::abs(delta) <= 1e-14 * std::max(1., std::abs(chi)))
+        {
+            break;
+        }
+    }
+    stumpff(alpha * chi * chi, c, s);
+
+    // Lagrange coefficients
+    const double chi2{chi * chi};
+    const double f{1. - chi2 / distance * c};
+    const double g{dt - chi2 * chi / root * s};
+    double r1[3];
+    for (size_t k{0U}; k < 3U; ++k)
+    {
+        r1[k] = f * r0[k] + g * v0[k];
+    }
+    const double distance1{std::sqrt(r1[0] * r1[0] + r1[1] * r1[1] + r1[2] * r1[2])};
+    const double df{root / (distance1 * distance) * (alpha * chi2 * chi * s - chi)};
+    const double dg{1. - chi2 / distance1 * c};
+    for (size_t k{0U}; k < 3U; ++k)
+    {
+        r[k] = static_cast<T>(r1[k]);
+        v[k] = static_cast<T>(df * r0[k] + dg * v0[k]);
+    }
+}
+
+/**
+ * @brief PlanetaryFunction class
+ *
+ * Split function of bodies in three dimensions, which orbit a dominant
+ * central body. The positions and velocities are inertial, three values per
+ * body.
+ */
+template<typename T, size_t N = Dynamic, typename Enable = void>
+class PlanetaryFunction;
+
+template<typename T, size_t N>
+class PlanetaryFunction<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type> : public SplitFunction<T, N>
+{
+public:
+    /**
+     * Copy the gravitational parameters G * m of the bodies into a caller provided buffer
+     */
+    virtual void getMasses(Vector<T, N>& mu) const = 0;
+
+    /**
+     * Calculate the accelerations without the attraction of the central body
+     * @param x          Step variable
+     * @param q          Positions
+     * @param central    Index of the central body
+     * @param a          Calculated accelerations, the ones of the central body are ignored
+     */
+    virtual void interact(T x, const Vector<T, N>& q, size_t central, Vector<T, N>& a) = 0;
+};
+
+/**
+ * @brief WisdomHolman class
+ *
+ * Wisdom Holman mapping in democratic heliocentric coordinates (Duncan,
+ * Levison and Lee 1998): the positions relative to the central body, which
+ * is the most massive one, and the barycentric velocities. The Hamiltonian
+ * splits into the Kepler orbits around the central body, which are advanced
+ * exactly, the interactions of the other bodies and the motion of the central
+ * body. A step is the 2nd order composition
+ *
+ *     kick(dx / 2) jump(dx / 2) kepler(dx) jump(dx / 2) kick(dx / 2)
+ *
+ * with one evaluation of the interactions. The error scales with the mass
+ * ratio of the other bodies to the central one, so the steps can be a
+ * considerable fraction of the shortest orbital period.
+ */
+template<typename T, size_t N = Dynamic>
+class WisdomHolman
+{
+public:
+    WisdomHolman() = default;
+
+    /**
+     * Calculate integration step
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Planetary function
+     */
+    void calc(T x, T dx, PlanetaryFunction<T, N>& function)
+    {
+        step(x, dx, function, m_workspace, m_masses);
+    }
+
+    /**
+     * Calculate integration step without virtual dispatch
+     * @param x          Variable
+     * @param dx         Variable step
+     * @param function   Function providing the methods of PlanetaryFunction
+     * @param workspace  Reusable buffers
+     * @param masses     Reusable buffer of the gravitational parameters
+     */
+    template<typename F>
+    static void step(T x, T dx, F& function, Workspace<T, N>& workspace, Vector<T, N>& masses)
+    {
+        function.getState(workspace.y, workspace.yx);
+        function.getMasses(masses);
+        workspace.resize(0U, workspace.y.size());
+        Vector<T, N>& q{workspace.y};
+        Vector<T, N>& v{workspace.yx};
+        Vector<T, N>& a{workspace.dydx};
+        const size_t bodies{masses.size()};
+        if (bodies == 0U || q.size() != bodies * 3U)
+        {
+            return;
+        }
+
+        // Central body, total mass, center of mass and its velocity
+        size_t central{0U};
+        double total{0.};
+        double center[3]{};
+        double momentum[3]{};
+        for (size_t i{0U}; i < bodies; ++i)
+        {
+            central = masses[i] > masses[central] ? i : central;
+            total += masses[i];
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                center[k] += static_cast<double>(masses[i]) * q[i * 3U + k];
+                momentum[k] += static_cast<double>(masses[i]) * v[i * 3U + k];
+            }
+        }
+        if (total <= 0.)
+        {
+            return;
+        }
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            center[k] /= total;
+            momentum[k] /= total;
+        }
+        const double mu{masses[central]};
+
+        // Democratic heliocentric coordinates, the central body stays at the origin
+        const T origin[3]{q[central * 3U], q[central * 3U + 1U], q[central * 3U + 2U]};
+        for (size_t i{0U}; i < bodies; ++i)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                q[i * 3U + k] -= origin[k];
+                v[i * 3U + k] -= static_cast<T>(momentum[k]);
+            }
+        }
+
+        auto kick = [&](const T t, const T h) {
+            function.interact(t, q, central, a);
+            for (size_t i{0U}; i < bodies; ++i)
+            {
+                for (size_t k{0U}; i != central && k < 3U; ++k)
+                {
+                    v[i * 3U + k] += h * a[i * 3U + k];
+                }
+            }
+        };
+        auto jump = [&](const T h) {
+            double sum[3]{};
+            for (size_t i{0U}; i < bodies; ++i)
+            {
+                for (size_t k{0U}; i != central && k < 3U; ++k)
+                {
+                    sum[k] += static_cast<double>(masses[i]) * v[i * 3U + k];
+                }
+            }
+            for (size_t i{0U}; i < bodies; ++i)
+            {
+                for (size_t k{0U}; i != central && k < 3U; ++k)
+                {
+                    q[i * 3U + k] += static_cast<T>(h * sum[k] / mu);
+                }
+            }
+        };
+
+        const T half{dx / T{2}};
+        kick(x, half);
+        jump(half);
+        for (size_t i{0U}; i < bodies; ++i)
+        {
+            if (i != central)
+            {
+                kepler(mu, &q[i * 3U], &v[i * 3U], static_cast<double>(dx));
+            }
+        }
+        jump(half);
+        kick(x + dx, half);
+
+        // Inertial coordinates, the center of mass moves uniformly
+        double offset[3]{};
+        double velocity[3]{};
+        for (size_t i{0U}; i < bodies; ++i)
+        {
+            for (size_t k{0U}; i != central && k < 3U; ++k)
+            {
+                offset[k] += static_cast<double>(masses[i]) * q[i * 3U + k];
+                velocity[k] += static_cast<double>(masses[i]) * v[i * 3U + k];
+            }
+        }
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            // Position of the central body from the center of mass, its barycentric velocity from the total momentum
+            const double position{center[k] + momentum[k] * dx - offset[k] / total};
+            q[central * 3U + k] = static_cast<T>(position);
+            v[central * 3U + k] = static_cast<T>(-velocity[k] / mu);
+            for (size_t i{0U}; i < bodies; ++i)
+            {
+                if (i != central)
+                {
+                    q[i * 3U + k] += static_cast<T>(position);
+                }
+                v[i * 3U + k] += static_cast<T>(momentum[k]);
+            }
+        }
+        function.setState(q, v);
+    }
+
+private:
+    Workspace<T, N> m_workspace{};
+    Vector<T, N> m_masses{};
+};
+}
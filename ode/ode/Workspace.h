@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Vector.h"
+
+namespace ode
+{
+/**
+ * @brief Workspace class
+ *
+ * Caller owned buffers of a solver step. Once sized by the first step the
+ * buffers are reused, so subsequent steps of the same size do not allocate.
+ */
+template<typename T, size_t N = Dynamic, typename Enable = void>
+class Workspace;
+
+template<typename T, size_t N>
+class Workspace<T, N, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+public:
+    Workspace() = default;
+
+    /**
+     * Resize buffers
+     * @param stages     Number of stage buffers
+     * @param size       Number of parameters
+     */
+    void resize(const size_t stages, const size_t size)
+    {
+        y.resize(size);
+        yx.resize(size);
+        dy.resize(size);
+        dydx.resize(size);
+        if (k.size() < stages)
+        {
+            k.resize(stages);
+        }
+        for (auto& stage : k)
+        {
+            stage.resize(size);
+        }
+    }
+
+    Vector<T, N> y{}; //!< Parameters
+    Vector<T, N> yx{}; //!< Stage parameters
+    Vector<T, N> dy{}; //!< Parameter increment
+    Vector<T, N> dydx{}; //!< Derivative
+    std::vector<Vector<T, N>> k{}; //!< Stages
+};
+}
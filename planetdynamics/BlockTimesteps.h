@@ -0,0 +1,256 @@
+#pragma once
+
+#include "ode/Vector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pd
+{
+/**
+ * BlockTimesteps class
+ *
+ * Leapfrog in kick drift kick form with individual power of two time steps.
+ * A body on level l takes steps of dt / 2^l, so all steps of a block step dt
+ * are aligned. At each sub step all bodies are drifted, but the accelerations
+ * are calculated only for the active bodies, whose step ends. These take
+ * their closing half kick and their next time step is estimated from the
+ * acceleration and its change over the step, h = eta * |a| / |da/dt|. A body
+ * moves to a finer level at the end of any step, to the next coarser level
+ * only if its new step is aligned with the block.
+ */
+class BlockTimesteps
+{
+public:
+    BlockTimesteps() = default;
+
+    /**
+     * Set accuracy parameter eta of the time step criterion
+     */
+    void setAccuracy(const float_t eta)
+    {
+        m_eta = eta;
+    }
+
+    /**
+     * Set the number of levels below the block step, the finest step is dt / 2^levels
+     */
+    void setLevels(const size_t levels)
+    {
+        m_levels = std::min<size_t>(levels, 30U);
+        m_valid = false;
+    }
+
+    /**
+     * Start with new accelerations and levels at the next step
+     */
+    void reset()
+    {
+        m_valid = false;
+    }
+
+    /**
+     * Level of body i
+     */
+    [[nodiscard]] size_t level(const size_t i) const
+    {
+        return m_level[i];
+    }
+
+    /**
+     * Calculate a block step
+     * @param x          Variable
+     * @param dx         Block step, the largest step of a body
+     * @param q          Positions, three per body
+     * @param v          Velocities, three per body
+     * @param forces     Calculates the accelerations of the listed bodies as forces(x, q, active, count, a)
+     */
+    template<typename F>
+    void step(const float_t x, const float_t dx, ode::Vector<float_t>& q, ode::Vector<float_t>& v, F&& forces)
+    {
+        const size_t bodies{q.size() / 3U};
+        if (!m_valid || m_level.size() != bodies)
+        {
+            initialize(x, dx, q, v, forces);
+        }
+
+        const uint64_t end{uint64_t{1U} << m_levels};
+        const float_t unit{dx / static_cast<float_t>(end)};
+        uint64_t tick{0U};
+        while (tick < end)
+        {
+            // Opening half kicks of the bodies starting a step
+            size_t finest{0U};
+            for (size_t i{0U}; i < bodies; ++i)
+            {
+                if (tick % length(i) == 0U)
+                {
+                    const float_t half{.5F * unit * static_cast<float_t>(length(i))};
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        v[i * 3U + k] += half * m_acceleration[i * 3U + k];
+                        m_start[i * 3U + k] = m_acceleration[i * 3U + k];
+                    }
+                }
+                finest = std::max(finest, m_level[i]);
+            }
+
+            // Drift of all bodies to the end of the finest step
+            const uint64_t next{tick + (uint64_t{1U} << (m_levels - finest))};
+            const float_t drift{unit * static_cast<float_t>(next - tick)};
+            for (size_t i{0U}; i < q.size(); ++i)
+            {
+                q[i] += drift * v[i];
+            }
+            tick = next;
+
+            // Accelerations and closing half kicks of the bodies ending their step
+            m_active.clear();
+            for (size_t i{0U}; i < bodies; ++i)
+            {
+                if (tick % length(i) == 0U)
+                {
+                    m_active.push_back(i);
+                }
+            }
+            forces(x + unit * static_cast<float_t>(tick), q, m_active.data(), m_active.size(), m_acceleration);
+            for (const size_t i : m_active)
+            {
+                const float_t h{unit * static_cast<float_t>(length(i))};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    v[i * 3U + k] += .5F * h * m_acceleration[i * 3U + k];
+                }
+                const size_t level{estimate(i, h, dx)};
+                if (level > m_level[i])
+                {
+                    m_level[i] = level;
+                }
+                else if (level < m_level[i] && tick % (2U * length(i)) == 0U)
+                {
+                    --m_level[i];
+                }
+            }
+        }
+    }
+
+    /**
+     * Save the number of levels, the levels and accelerations, see ode/Checkpoint.h
+     */
+    template<typename A>
+    void write(A& archive) const
+    {
+        archive.write(static_cast<uint64_t>(m_levels));
+        archive.write(static_cast<uint64_t>(m_valid ? m_level.size() : 0U));
+        std::vector<uint64_t> levels(m_level.begin(), m_level.end());
+        archive.write(levels);
+        archive.write(m_acceleration.data(), m_acceleration.size());
+    }
+
+    /**
+     * Restore the levels and accelerations, levels finer than the current number of levels are clamped to it
+     */
+    template<typename A>
+    bool read(A& archive)
+    {
+        uint64_t stored{0U};
+        uint64_t bodies{0U};
+        std::vector<uint64_t> levels{};
+        if (!archive.read(stored) || !archive.read(bodies) || !archive.read(levels) || levels.size() != bodies ||
+            std::any_of(levels.begin(), levels.end(), [stored](uint64_t level) { return level > stored; }))
+        {
+            return false;
+        }
+        m_acceleration.resize(bodies * 3U);
+        m_start.resize(bodies * 3U);
+        if (!archive.read(m_acceleration.data(), m_acceleration.size()))
+        {
+            return false;
+        }
+        m_level.resize(levels.size());
+        std::transform(levels.begin(), levels.end(), m_level.begin(), [this](uint64_t level) { return static_cast<size_t>(std::min<uint64_t>(level, m_levels)); });
+        m_valid = bodies > 0U;
+        return true;
+    }
+
+private:
+    /**
+     * Number of ticks of a step of body i
+     */
+    [[nodiscard]] uint64_t length(const size_t i) const
+    {
+        return uint64_t{1U} << (m_levels - m_level[i]);
+    }
+
+    /**
+     * Return the level of the time step estimated from the accelerations at the start and the end of a step of length h
+     */
+    [[nodiscard]] size_t estimate(const size_t i, const float_t h, const float_t dx) const
+    {
+        float_t a2{0.F};
+        float_t da2{0.F};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            const float_t a{m_acceleration[i * 3U + k]};
+            const float_t da{a - m_start[i * 3U + k]};
+            a2 += a * a;
+            da2 += da * da;
+        }
+        if (da2 <= 0.F)
+        {
+            return 0U;
+        }
+        // h_new = eta * |a| / |da/dt| = eta * h * |a| / |da|
+        const float_t step{m_eta * h * std::sqrt(a2 / da2)};
+        size_t level{0U};
+        for (float_t length{dx}; length > step && level < m_levels; length *= .5F)
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    /**
+     * Calculate the accelerations of all bodies and their levels from a trial drift
+     */
+    template<typename F>
+    void initialize(const float_t x, const float_t dx, ode::Vector<float_t>& q, const ode::Vector<float_t>& v, F&& forces)
+    {
+        const size_t bodies{q.size() / 3U};
+        m_level.assign(bodies, 0U);
+        m_acceleration.assign(bodies * 3U, 0.F);
+        m_start.assign(bodies * 3U, 0.F);
+        m_active.resize(bodies);
+        for (size_t i{0U}; i < bodies; ++i)
+        {
+            m_active[i] = i;
+        }
+        forces(x, q, m_active.data(), bodies, m_start);
+
+        // The change of the accelerations over a short drift estimates their derivative
+        const float_t trial{dx / static_cast<float_t>(uint64_t{1U} << (m_levels / 2U))};
+        ode::Vector<float_t> moved{q};
+        for (size_t i{0U}; i < q.size(); ++i)
+        {
+            moved[i] += trial * v[i];
+        }
+        forces(x + trial, moved, m_active.data(), bodies, m_acceleration);
+        for (size_t i{0U}; i < bodies; ++i)
+        {
+            m_level[i] = estimate(i, trial, dx);
+        }
+        std::swap(m_acceleration, m_start);
+        m_valid = true;
+    }
+
+    float_t m_eta{0.02F}; //!< Accuracy parameter
+    size_t m_levels{16U}; //!< Number of levels below the block step
+    bool m_valid{false}; //!< Levels and accelerations match the bodies
+    std::vector<size_t> m_level{}; //!< Level of each body
+    ode::Vector<float_t> m_acceleration{}; //!< Accelerations at the end of the last step of each body
+    ode::Vector<float_t> m_start{}; //!< Accelerations at the start of the current step of each body
+    std::vector<size_t> m_active{}; //!< Bodies ending their step
+};
+}
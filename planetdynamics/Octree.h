@@ -0,0 +1,473 @@
+#pragma once
+
+#include "ode/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace pd
+{
+/**
+ * Octree class
+ *
+ * Barnes Hut approximation of the gravitational accelerations. The bodies are
+ * sorted along a Morton curve of their bounding cube, so every node of the
+ * octree covers a contiguous range of the sorted bodies. The nodes are stored
+ * depth first, the children follow their parent and each node knows the node
+ * after its subtree, which makes the traversal a loop without stack. A body
+ * takes the monopole of a node, if the node is smaller than the opening angle
+ * theta times its distance to the center of mass, otherwise it opens the node.
+ *
+ * The keys are calculated and sorted in parallel. The top levels of the tree
+ * are split into subtrees, which are built in parallel and spliced into the
+ * node array afterwards. The accelerations are calculated in parallel in key
+ * order, so neighboring bodies walk similar paths of the tree.
+ */
+class Octree
+{
+public:
+    Octree() = default;
+
+    /**
+     * Set opening angle
+     * @param theta      A node is opened if its side length exceeds theta times its distance, zero opens all nodes
+     */
+    void setTheta(const float_t theta)
+    {
+        m_theta = theta;
+    }
+
+    [[nodiscard]] float_t theta() const
+    {
+        return m_theta;
+    }
+
+    /**
+     * Number of nodes of the last build
+     */
+    [[nodiscard]] size_t size() const
+    {
+        return m_nodes.size();
+    }
+
+    /**
+     * Build the tree
+     * @param count      Number of bodies
+     * @param position   Function returning the coordinate k of body i as position(i, k)
+     * @param mass       Masses of the bodies
+     * @param pool       Threads
+     */
+    template<typename P>
+    void build(const size_t count, P&& position, const float_t* mass, ode::ThreadPool& pool)
+    {
+        m_nodes.clear();
+        m_entries.resize(count);
+        if (count == 0U)
+        {
+            return;
+        }
+
+        // Bounding cube
+        const size_t threads{pool.size()};
+        m_bounds.assign(threads * 6U, 0.F);
+        for (size_t t{0U}; t < threads; ++t)
+        {
+            std::fill_n(m_bounds.begin() + static_cast<std::ptrdiff_t>(t * 6U), 3U, std::numeric_limits<float_t>::max());
+            std::fill_n(m_bounds.begin() + static_cast<std::ptrdiff_t>(t * 6U + 3U), 3U, std::numeric_limits<float_t>::lowest());
+        }
+        pool.parallelFor(count, GRAIN, [&](size_t thread, size_t begin, size_t end) {
+            float_t* lower{m_bounds.data() + thread * 6U};
+            float_t* upper{lower + 3U};
+            for (size_t i{begin}; i < end; ++i)
+            {
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    lower[k] = std::min(lower[k], position(i, k));
+                    upper[k] = std::max(upper[k], position(i, k));
+                }
+            }
+        });
+        float_t side{0.F};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            m_lower[k] = std::numeric_limits<float_t>::max();
+            float_t upper{std::numeric_limits<float_t>::lowest()};
+            for (size_t t{0U}; t < threads; ++t)
+            {
+                m_lower[k] = std::min(m_lower[k], m_bounds[t * 6U + k]);
+                upper = std::max(upper, m_bounds[t * 6U + 3U + k]);
+            }
+            side = std::max(side, upper - m_lower[k]);
+        }
+        m_side = side > 0.F ? side * (1.F + 1e-5F) : 1.F;
+
+        // Morton keys in key order
+        const float_t scale{static_cast<float_t>(1U << LEVELS) / m_side};
+        pool.parallelFor(count, GRAIN, [&](size_t, size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i)
+            {
+                uint64_t key{0U};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    const auto cell = static_cast<uint64_t>(std::max((position(i, k) - m_lower[k]) * scale, 0.F));
+                    key |= spread(std::min<uint64_t>(cell, (1U << LEVELS) - 1U)) << k;
+                }
+                m_entries[i] = Entry{key, static_cast<uint32_t>(i)};
+            }
+        });
+        sort(pool);
+
+        for (auto& values : m_position)
+        {
+            values.resize(count);
+        }
+        m_mass.resize(count);
+        m_index.resize(count);
+        m_rank.resize(count);
+        pool.parallelFor(count, GRAIN, [&](size_t, size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i)
+            {
+                const uint32_t index{m_entries[i].index};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    m_position[k][i] = position(index, k);
+                }
+                m_mass[i] = mass[index];
+                m_index[i] = index;
+                m_rank[index] = static_cast<uint32_t>(i);
+            }
+        });
+
+        // Top levels on the calling thread, their subtrees in parallel
+        size_t split{0U};
+        while (threads > 1U && (size_t{1U} << (3U * split)) < 4U * threads)
+        {
+            ++split;
+        }
+        m_tasks.clear();
+        tasks(0U, static_cast<uint32_t>(count), 0U, split);
+        m_subtrees.resize(std::max(m_subtrees.size(), m_tasks.size()));
+        pool.parallelFor(m_tasks.size(), 1U, [&](size_t, size_t begin, size_t end) {
+            for (size_t t{begin}; t < end; ++t)
+            {
+                m_subtrees[t].clear();
+                subtree(m_subtrees[t], m_tasks[t].begin, m_tasks[t].end, m_tasks[t].level);
+            }
+        });
+        size_t task{0U};
+        assemble(0U, static_cast<uint32_t>(count), 0U, split, task);
+    }
+
+    /**
+     * Calculate the accelerations of all bodies
+     * @param store      Function called as store(i, acceleration) with the three components of body i, in parallel for different bodies
+     * @param pool       Threads
+     */
+    template<typename S>
+    void accelerations(S&& store, ode::ThreadPool& pool) const
+    {
+        pool.parallelFor(m_index.size(), TRAVERSAL, [&](size_t, size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i)
+            {
+                float_t acceleration[3]{};
+                traverse(static_cast<uint32_t>(i), acceleration);
+                store(static_cast<size_t>(m_index[i]), static_cast<const float_t*>(acceleration));
+            }
+        });
+    }
+
+    /**
+     * Calculate the accelerations of the listed bodies
+     * @param active     Bodies
+     * @param count      Number of listed bodies
+     * @param store      Function called as store(i, acceleration) with the three components of body i, in parallel for different bodies
+     * @param pool       Threads
+     */
+    template<typename S>
+    void accelerations(const size_t* active, const size_t count, S&& store, ode::ThreadPool& pool) const
+    {
+        pool.parallelFor(count, TRAVERSAL, [&](size_t, size_t begin, size_t end) {
+            for (size_t n{begin}; n < end; ++n)
+            {
+                float_t acceleration[3]{};
+                traverse(m_rank[active[n]], acceleration);
+                store(active[n], static_cast<const float_t*>(acceleration));
+            }
+        });
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t key{0U}; //!< Morton key
+        uint32_t index{0U}; //!< Body
+
+        bool operator<(const Entry& other) const
+        {
+            return key < other.key || (key == other.key && index < other.index);
+        }
+    };
+
+    struct Node
+    {
+        float_t center[3]{}; //!< Center of mass
+        float_t mass{0.F}; //!< Total mass
+        float_t open{0.F}; //!< Squared distance, below which the node is opened
+        uint32_t begin{0U}; //!< First body in key order
+        uint32_t end{0U}; //!< End of the bodies in key order
+        uint32_t next{0U}; //!< Node after the subtree, a leaf if it is the next node
+    };
+
+    struct Task
+    {
+        uint32_t begin{0U};
+        uint32_t end{0U};
+        size_t level{0U};
+    };
+
+    /**
+     * Spread the lower 21 bits of a coordinate to every third bit
+     */
+    static uint64_t spread(uint64_t value)
+    {
+        value &= 0x1fffffU;
+        value = (value | value << 32U) & 0x1f00000000ffffU;
+        value = (value | value << 16U) & 0x1f0000ff0000ffU;
+        value = (value | value << 8U) & 0x100f00f00f00f00fU;
+        value = (value | value << 4U) & 0x10c30c30c30c30c3U;
+        value = (value | value << 2U) & 0x1249249249249249U;
+        return value;
+    }
+
+    /**
+     * Add the acceleration of the body at position i in key order by a traversal of the tree
+     */
+    void traverse(const uint32_t i, float_t* acceleration) const
+    {
+        const auto nodes = static_cast<uint32_t>(m_nodes.size());
+        const float_t r[3]{m_position[0][i], m_position[1][i], m_position[2][i]};
+        uint32_t n{0U};
+        while (n < nodes)
+        {
+            const Node& node{m_nodes[n]};
+            const float_t d[3]{node.center[0] - r[0], node.center[1] - r[1], node.center[2] - r[2]};
+            const float_t r2{d[0] * d[0] + d[1] * d[1] + d[2] * d[2]};
+            const bool inside{i >= node.begin && i < node.end};
+            if (!inside && r2 > node.open)
+            {
+                // Monopole of the node
+                const float_t f{node.mass / (r2 * std::sqrt(r2))};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    acceleration[k] += f * d[k];
+                }
+                n = node.next;
+            }
+            else if (node.next == n + 1U)
+            {
+                // Bodies of the leaf
+                for (uint32_t j{node.begin}; j < node.end; ++j)
+                {
+                    if (j != i)
+                    {
+                        const float_t dj[3]{m_position[0][j] - r[0], m_position[1][j] - r[1], m_position[2][j] - r[2]};
+                        const float_t rj2{dj[0] * dj[0] + dj[1] * dj[1] + dj[2] * dj[2]};
+                        const float_t f{m_mass[j] / (rj2 * std::sqrt(rj2))};
+                        for (size_t k{0U}; k < 3U; ++k)
+                        {
+                            acceleration[k] += f * dj[k];
+                        }
+                    }
+                }
+                n = node.next;
+            }
+            else
+            {
+                ++n;
+            }
+        }
+    }
+
+    /**
+     * Sort the entries by key, chunks are sorted per thread and merged pairwise
+     */
+    void sort(ode::ThreadPool& pool)
+    {
+        const size_t count{m_entries.size()};
+        const size_t chunks{pool.size()};
+        if (chunks == 1U || count < PARALLEL)
+        {
+            std::sort(m_entries.begin(), m_entries.end());
+            return;
+        }
+        auto bound = [count, chunks](size_t c) { return static_cast<std::ptrdiff_t>(count * std::min(c, chunks) / chunks); };
+        pool.run([&](size_t thread) { std::sort(m_entries.begin() + bound(thread), m_entries.begin() + bound(thread + 1U)); });
+        m_buffer.resize(count);
+        for (size_t width{1U}; width < chunks; width *= 2U)
+        {
+            pool.parallelFor((chunks + 2U * width - 1U) / (2U * width), 1U, [&](size_t, size_t begin, size_t end) {
+                for (size_t p{begin}; p < end; ++p)
+                {
+                    const auto first = m_entries.begin();
+                    std::merge(first + bound(2U * p * width), first + bound((2U * p + 1U) * width), first + bound((2U * p + 1U) * width), first + bound((2U * p + 2U) * width), m_buffer.begin() + bound(2U * p * width));
+                }
+            });
+            std::swap(m_entries, m_buffer);
+        }
+    }
+
+    /**
+     * Return true if the bodies [begin, end) at level are split into children
+     */
+    [[nodiscard]] static bool divided(const uint32_t begin, const uint32_t end, const size_t level)
+    {
+        return end - begin > LEAF && level < LEVELS;
+    }
+
+    /**
+     * Call visit(begin, end) for the nonempty children of the bodies [begin, end) at level
+     */
+    template<typename V>
+    void children(const uint32_t begin, const uint32_t end, const size_t level, V&& visit) const
+    {
+        const size_t shift{3U * (LEVELS - 1U - level)};
+        const auto first = m_entries.begin();
+        uint32_t child{begin};
+        while (child < end)
+        {
+            const uint64_t octant{(m_entries[child].key >> shift) & 7U};
+            const auto last = static_cast<uint32_t>(std::partition_point(first + child, first + end, [shift, octant](const Entry& entry) { return ((entry.key >> shift) & 7U) == octant; }) - first);
+            visit(child, last);
+            child = last;
+        }
+    }
+
+    /**
+     * Collect the subtrees below the top levels in key order
+     */
+    void tasks(const uint32_t begin, const uint32_t end, const size_t level, const size_t split)
+    {
+        if (level < split && divided(begin, end, level))
+        {
+            children(begin, end, level, [&](uint32_t b, uint32_t e) { tasks(b, e, level + 1U, split); });
+            return;
+        }
+        m_tasks.push_back(Task{begin, end, level});
+    }
+
+    /**
+     * Build the top levels into the node array and splice the built subtrees in key order
+     */
+    void assemble(const uint32_t begin, const uint32_t end, const size_t level, const size_t split, size_t& task)
+    {
+        if (!(level < split && divided(begin, end, level)))
+        {
+            const auto offset = static_cast<uint32_t>(m_nodes.size());
+            for (Node node : m_subtrees[task++])
+            {
+                node.next += offset;
+                m_nodes.push_back(node);
+            }
+            return;
+        }
+        const size_t self{m_nodes.size()};
+        m_nodes.push_back(create(begin, end, level));
+        children(begin, end, level, [&](uint32_t b, uint32_t e) { assemble(b, e, level + 1U, split, task); });
+        finish(m_nodes, self);
+    }
+
+    /**
+     * Build the subtree of the bodies [begin, end) at level
+     */
+    void subtree(std::vector<Node>& nodes, const uint32_t begin, const uint32_t end, const size_t level) const
+    {
+        const size_t self{nodes.size()};
+        nodes.push_back(create(begin, end, level));
+        if (divided(begin, end, level))
+        {
+            children(begin, end, level, [&](uint32_t b, uint32_t e) { subtree(nodes, b, e, level + 1U); });
+            finish(nodes, self);
+            return;
+        }
+
+        // Moments of the leaf
+        Node& leaf{nodes[self]};
+        for (uint32_t i{begin}; i < end; ++i)
+        {
+            leaf.mass += m_mass[i];
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                leaf.center[k] += m_mass[i] * m_position[k][i];
+            }
+        }
+        center(leaf);
+        leaf.next = static_cast<uint32_t>(nodes.size());
+    }
+
+    /**
+     * Create a node without moments
+     */
+    [[nodiscard]] Node create(const uint32_t begin, const uint32_t end, const size_t level) const
+    {
+        const float_t side{m_side / static_cast<float_t>(size_t{1U} << level)};
+        Node node{};
+        node.open = m_theta > 0.F ? side * side / (m_theta * m_theta) : std::numeric_limits<float_t>::max();
+        node.begin = begin;
+        node.end = end;
+        return node;
+    }
+
+    /**
+     * Sum the moments of the children of an inner node, which follow it up to the end of the array
+     */
+    void finish(std::vector<Node>& nodes, const size_t self) const
+    {
+        Node& parent{nodes[self]};
+        parent.next = static_cast<uint32_t>(nodes.size());
+        for (size_t n{self + 1U}; n < nodes.size(); n = nodes[n].next)
+        {
+            parent.mass += nodes[n].mass;
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                parent.center[k] += nodes[n].mass * nodes[n].center[k];
+            }
+        }
+        center(parent);
+    }
+
+    /**
+     * Divide the mass weighted positions by the mass, massless nodes take the position of their first body
+     */
+    void center(Node& node) const
+    {
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            node.center[k] = node.mass > 0.F ? node.center[k] / node.mass : m_position[k][node.begin];
+        }
+    }
+
+    static constexpr size_t LEVELS{21U}; //!< Levels of the Morton keys, 3 * 21 bits
+    static constexpr uint32_t LEAF{8U}; //!< Maximum number of bodies of a leaf
+    static constexpr size_t GRAIN{4096U}; //!< Bodies per scheduled chunk of the build
+    static constexpr size_t TRAVERSAL{64U}; //!< Bodies per scheduled chunk of the traversal
+    static constexpr size_t PARALLEL{1U << 12U}; //!< Minimum number of bodies sorted in parallel
+
+    float_t m_theta{0.5F}; //!< Opening angle
+    float_t m_lower[3]{}; //!< Lower corner of the bounding cube
+    float_t m_side{1.F}; //!< Side length of the bounding cube
+    std::vector<float_t> m_bounds{}; //!< Bounds per thread
+    std::vector<Entry> m_entries{}; //!< Keys in key order
+    std::vector<Entry> m_buffer{}; //!< Merge buffer
+    std::vector<float_t> m_position[3]{}; //!< Positions per axis in key order
+    std::vector<float_t> m_mass{}; //!< Masses in key order
+    std::vector<uint32_t> m_index{}; //!< Body of each position in key order
+    std::vector<uint32_t> m_rank{}; //!< Position in key order of each body
+    std::vector<Task> m_tasks{}; //!< Subtrees built in parallel
+    std::vector<std::vector<Node>> m_subtrees{}; //!< Nodes of each subtree
+    std::vector<Node> m_nodes{}; //!< Nodes depth first
+};
+}
@@ -0,0 +1,599 @@
+#pragma once
+
+#include "BlockTimesteps.h"
+#include "Gravity.h"
+#include "Octree.h"
+#include "ode/Checkpoint.h"
+#include "ode/FrameWriter.h"
+#include "ode/RungeKutta.h"
+#include "ode/TextReader.h"
+#include "ode/Symplectic.h"
+#include "ode/ThreadPool.h"
+#include "ode/WisdomHolman.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pd
+{
+using Vector = ode::Vector<float_t>;
+using Vector3 = ode::Vector<float_t, 3>;
+using Function = ode::Function<float_t>;
+using PlanetaryFunction = ode::PlanetaryFunction<float_t>;
+using RungeKutta = ode::RungeKutta<float_t>;
+using Leapfrog = ode::Leapfrog<float_t>;
+using Yoshida4 = ode::Yoshida4<float_t>;
+using WisdomHolman = ode::WisdomHolman<float_t>;
+using FrameWriter = ode::FrameWriter<float_t>;
+
+/**
+ * Body class
+ */
+class Body
+{
+public:
+    Body() = default;
+    std::string name{}; //!< Planet name
+    Vector3 position{}; //!< Position vector
+    Vector3 velocity{}; //!< Velocity vector
+    float_t radius{0.F}; //!< Radius
+    float_t mass{0.F}; //!< Mass
+};
+
+/**
+ * World class
+ */
+class World : public Function, public PlanetaryFunction
+{
+public:
+    /**
+     * @brief Integrators
+     */
+    enum class Integrator
+    {
+        RungeKutta, //!< Classical 4th order Runge Kutta
+        Leapfrog, //!< Symplectic 2nd order leapfrog
+        Yoshida4, //!< Symplectic 4th order Yoshida
+        WisdomHolman, //!< Symplectic Wisdom Holman mapping around the most massive body
+        BlockTimesteps //!< Leapfrog with individual power of two time steps
+    };
+
+    World() = default;
+
+    /**
+     * Return the integrator of the given name (rk4, leapfrog, yoshida4, wh, block), RungeKutta if unknown
+     */
+    static Integrator toIntegrator(const std::string& name)
+    {
+        return name == "leapfrog" ? Integrator::Leapfrog : name == "yoshida4" ? Integrator::Yoshida4 : name == "wh" ? Integrator::WisdomHolman : name == "block" ? Integrator::BlockTimesteps : Integrator::RungeKutta;
+    }
+
+    void setIntegrator(const Integrator integrator)
+    {
+        m_integrator = integrator;
+    }
+
+    /**
+     * Set the time step criterion of the block time steps, see BlockTimesteps.h
+     * @param eta        Accuracy parameter
+     * @param levels     Number of levels, the finest step is dt / 2^levels
+     */
+    void setBlockTimesteps(const float_t eta, const size_t levels)
+    {
+        m_blocks.setAccuracy(eta);
+        m_blocks.setLevels(levels);
+    }
+
+    /**
+     * Number of calculated accelerations of single bodies
+     */
+    [[nodiscard]] size_t evaluations() const
+    {
+        return m_evaluations;
+    }
+
+    void step(const float_t t, const float_t dt)
+    {
+        // Calculate new values
+        switch (m_integrator)
+        {
+        case Integrator::Leapfrog:
+            m_leapfrog.calc(t, dt, *this);
+            break;
+        case Integrator::Yoshida4:
+            m_yoshida.calc(t, dt, *this);
+            break;
+        case Integrator::WisdomHolman:
+            m_wisdomHolman.calc(t, dt, *this);
+            break;
+        case Integrator::BlockTimesteps:
+            getState(m_positions, m_velocities);
+            m_blocks.step(t, dt, m_positions, m_velocities, [this](float_t, const Vector& q, const size_t* active, size_t count, Vector& a) {
+                gravity([&q](size_t i, size_t k) { return q[i * 3U + k]; }, masses(), active, count, [&a](size_t i, const float_t* acceleration) { std::copy(acceleration, acceleration + 3, &a[i * 3U]); });
+            });
+            setState(m_positions, m_velocities);
+            break;
+        default:
+        {
+            // Through the base, the overrides of the Function interface aren't public
+            Function& function{*this};
+            m_solver.step(t, dt, function, m_workspace);
+            break;
+        }
+        }
+        m_time = t + dt;
+
+        // Print results to files
+        print();
+
+        // Save checkpoint
+        if (m_checkpointInterval > 0U && m_frames % m_checkpointInterval == 0U)
+        {
+            checkpoint(m_checkpointFile);
+        }
+    }
+
+    void print()
+    {
+        for (auto& body : m_bodies)
+        {
+            m_rangeX[0] = std::min(m_rangeX[0], body.position[0]);
+            m_rangeX[1] = std::min(m_rangeX[1], body.position[0]);
+            m_rangeY[0] = std::min(m_rangeY[0], body.position[1]);
+            m_rangeY[1] = std::min(m_rangeY[1], body.position[1]);
+        }
+        m_frames++;
+
+        // Selected bodies, formatted and written by the writer thread
+        const size_t first{std::min(m_outputFirst, m_bodies.size())};
+        const size_t end{first + selected()};
+        m_writer.push(m_time, (end - first) * 3U, [this, first, end](float_t* values) {
+            for (size_t i{first}; i < end; ++i)
+            {
+                *values++ = m_bodies[i].position[0];
+                *values++ = m_bodies[i].position[1];
+                *values++ = m_bodies[i].position[2];
+            }
+        });
+    }
+
+    /**
+     * Set behaviour of the trajectory output if the disk falls behind
+     */
+    void setOutputPolicy(const FrameWriter::Policy policy)
+    {
+        m_writer.setPolicy(policy);
+    }
+
+    /**
+     * Write the trajectory in the binary format of ode/Trajectory.h instead of text, must be called before initialize
+     * @param binary     Binary output
+     * @param dt         Time step stored in the file header
+     */
+    void setBinaryOutput(const bool binary, const float_t dt)
+    {
+        m_binary = binary;
+        m_timeStep = dt;
+    }
+
+    /**
+     * Select the written frames and bodies, must be called before initialize
+     * @param stride     Every stride-th step is written
+     * @param first      First written body
+     * @param count      Number of written bodies, zero for all from first
+     * @param split      Split the trajectory into a file per body at the end, the trajectory is written in the binary format
+     */
+    void setOutput(const size_t stride, const size_t first, const size_t count, const bool split)
+    {
+        m_stride = std::max<size_t>(stride, 1U);
+        m_outputFirst = first;
+        m_outputCount = count;
+        m_split = split;
+        m_binary = m_binary || split;
+    }
+
+    bool initialize(const std::string& filename)
+    {
+        ode::TextReader<float_t> reader{};
+        uint32_t count{0U};
+        // Each of the five words of a body takes at least a byte, larger counts are invalid
+        bool valid{reader.open(filename) && reader.read(count) && static_cast<size_t>(count) <= reader.remaining() / 5U};
+        if (valid)
+        {
+            std::cout << "Number of bodies = " << count << std::endl;
+            m_bodies.resize(count);
+        }
+        for (uint32_t i{0U}; valid && i < count; ++i)
+        {
+            valid = reader.read(m_bodies[i].name) && reader.read(m_bodies[i].position[0]) && reader.read(m_bodies[i].velocity[1]) && reader.read(m_bodies[i].mass) && reader.read(m_bodies[i].radius);
+            std::cout << m_bodies[i].name << " d=" << m_bodies[i].position[0] << " v=" << m_bodies[i].velocity[1] << " m=" << m_bodies[i].mass << " r=" << m_bodies[i].radius << std::endl;
+        }
+        if (valid)
+        {
+            m_blocks.reset();
+            return openOutput();
+        }
+        std::cout << "Invalid file " << filename.c_str() << std::endl;
+        return false;
+    }
+
+    /**
+     * Save periodic checkpoints
+     * @param interval   Steps between checkpoints, zero for none
+     * @param filename   Checkpoint file, replaced by each checkpoint
+     */
+    void setCheckpoint(const size_t interval, const std::string& filename)
+    {
+        m_checkpointInterval = interval;
+        m_checkpointFile = filename;
+    }
+
+    /**
+     * Save the complete state in the background, the caller only copies the state
+     * @return false if the checkpoint was skipped because the previous ones are still written
+     */
+    bool checkpoint(const std::string& filename)
+    {
+        return m_checkpoints.save(filename, CHECKPOINT, [this](ode::Archive& archive) {
+            archive.write(static_cast<uint64_t>(m_bodies.size()));
+            for (const auto& body : m_bodies)
+            {
+                archive.write(body.name);
+                archive.write(body.position.data(), body.position.size());
+                archive.write(body.velocity.data(), body.velocity.size());
+                archive.write(body.radius);
+                archive.write(body.mass);
+            }
+            archive.write(m_time);
+            archive.write(static_cast<uint64_t>(m_frames));
+            archive.write(m_rangeX, 2U);
+            archive.write(m_rangeY, 2U);
+            m_blocks.write(archive);
+        });
+    }
+
+    /**
+     * Restore the state of a checkpoint, the run continues as it would have from the checkpoint
+     */
+    bool restore(const std::string& filename)
+    {
+        ode::Archive archive{};
+        uint64_t count{0U};
+        // A body takes at least the size of its name and eight values, larger counts are invalid
+        static constexpr size_t BODY{sizeof(uint64_t) + 8U * sizeof(float_t)};
+        bool valid{archive.load(filename, CHECKPOINT) && archive.read(count) && count <= archive.remaining() / BODY};
+        m_bodies.resize(valid ? static_cast<size_t>(count) : 0U);
+        for (auto& body : m_bodies)
+        {
+            valid = valid && archive.read(body.name) && archive.read(body.position.data(), body.position.size()) && archive.read(body.velocity.data(), body.velocity.size()) && archive.read(body.radius) && archive.read(body.mass);
+        }
+        uint64_t frames{0U};
+        if (valid && archive.read(m_time) && archive.read(frames) && archive.read(m_rangeX, 2U) && archive.read(m_rangeY, 2U) && m_blocks.read(archive))
+        {
+            m_frames = frames;
+            std::cout << "Number of bodies = " << m_bodies.size() << ", time = " << m_time << std::endl;
+            return true;
+        }
+        std::cout << "Invalid checkpoint " << filename.c_str() << std::endl;
+        return false;
+    }
+
+    /**
+     * Open the trajectory outputs, called by initialize or after restore
+     * @return false if the output file can't be opened
+     */
+    bool openOutput()
+    {
+        m_writer.setStride(m_stride, m_frames);
+        const std::string filename{m_binary ? "Solarsystem.trj" : "Solarsystem.dat"};
+        const bool opened{m_binary ? m_writer.openBinary(filename, 0U, selected() * 3U, 3U, m_timeStep * static_cast<float_t>(m_stride)) : m_writer.open(filename, 0U, selected() * 3U)};
+        if (!opened)
+        {
+            std::cout << "Cannot open output " << filename.c_str() << std::endl;
+        }
+        return opened;
+    }
+
+    [[nodiscard]] float_t time() const
+    {
+        return m_time;
+    }
+
+    /**
+     * Initialize world with the given bodies without output files
+     */
+    void initialize(std::vector<Body>&& bodies)
+    {
+        m_bodies = std::move(bodies);
+        m_blocks.reset();
+    }
+
+    /**
+     * Select the vectorized or the scalar pair kernel of the direct sum, see Gravity.h
+     */
+    void setVectorized(const bool vectorized)
+    {
+        m_direct.setVectorized(vectorized);
+    }
+
+    /**
+     * Set number of threads of the gravity, zero for all cores
+     */
+    void setThreads(const size_t threads)
+    {
+        m_pool = std::make_unique<ode::ThreadPool>(threads);
+    }
+
+    /**
+     * Set opening angle of the Barnes Hut forces, see Octree.h
+     * @param theta      Opening angle, zero calculates the forces of all pairs
+     */
+    void setTheta(const float_t theta)
+    {
+        m_theta = theta;
+        m_octree.setTheta(theta);
+    }
+
+    void finish()
+    {
+        if (m_checkpointInterval > 0U)
+        {
+            m_checkpoints.wait();
+            checkpoint(m_checkpointFile);
+            m_checkpoints.wait();
+        }
+        m_writer.close();
+        if (m_split)
+        {
+            // Post processing instead of a file per body in every step
+            ode::TrajectoryReader<float_t> reader{};
+            const size_t first{std::min(m_outputFirst, m_bodies.size())};
+            const size_t files{reader.open("Solarsystem.trj") ? ode::split(reader, 0U, reader.particles(), [this, first](size_t i) { return m_bodies[first + i].name + ".dat"; }) : 0U};
+            std::cout << "Split files = " << files << std::endl;
+        }
+        std::cout << "Range = [" << m_rangeX[0] << ":" << m_rangeX[1] << ", " << m_rangeY[0] << ":" << m_rangeY[1] << "]" << std::endl;
+        std::cout << "Frames = " << m_frames << std::endl;
+        std::cout << "Written frames = " << m_writer.written() << std::endl;
+        std::cout << "Force evaluations = " << m_evaluations << std::endl;
+        if (m_writer.dropped() > 0U)
+        {
+            std::cout << "Dropped frames = " << m_writer.dropped() << std::endl;
+        }
+        if (m_checkpoints.failed() > 0U)
+        {
+            std::cout << "Failed checkpoints = " << m_checkpoints.failed() << std::endl;
+        }
+    }
+
+protected:
+    Vector derive(float_t x, Vector& y) final
+    {
+        Vector dydx(y.size());
+        derive(x, y, dydx);
+        return dydx;
+    }
+
+    void derive([[maybe_unused]] float_t x, Vector& y, Vector& dydx) final
+    {
+        const size_t count{m_bodies.size()};
+        dydx.resize(count * 6U);
+        for (size_t a{0U}; a < count; ++a)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                // Position
+                dydx[a * 6U + k] = y[a * 6U + k + 3U];
+            }
+        }
+
+        // Velocity
+        gravity([&y](size_t i, size_t k) { return y[i * 6U + k]; }, masses(), [&dydx](size_t i, const float_t* acceleration) {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                dydx[i * 6U + k + 3U] = acceleration[k];
+            }
+        });
+    }
+
+    void getState(Vector& q, Vector& v) const final
+    {
+        q.resize(m_bodies.size() * 3U);
+        v.resize(m_bodies.size() * 3U);
+        for (size_t i{0U}; i < m_bodies.size(); ++i)
+        {
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                q[i * 3U + k] = m_bodies[i].position[k];
+                v[i * 3U + k] = m_bodies[i].velocity[k];
+            }
+        }
+    }
+
+    void setState(const Vector& q, const Vector& v) final
+    {
+        if (q.size() == m_bodies.size() * 3U && v.size() == q.size())
+        {
+            for (size_t i{0U}; i < m_bodies.size(); ++i)
+            {
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    m_bodies[i].position[k] = q[i * 3U + k];
+                    m_bodies[i].velocity[k] = v[i * 3U + k];
+                }
+            }
+        }
+    }
+
+    void accelerate([[maybe_unused]] float_t x, const Vector& q, Vector& a) final
+    {
+        a.resize(q.size());
+        gravity([&q](size_t i, size_t k) { return q[i * 3U + k]; }, masses(), [&a](size_t i, const float_t* acceleration) { std::copy(acceleration, acceleration + 3, &a[i * 3U]); });
+    }
+
+    void getMasses(Vector& mu) const final
+    {
+        mu.resize(m_bodies.size());
+        for (size_t i{0U}; i < m_bodies.size(); ++i)
+        {
+            mu[i] = m_bodies[i].mass;
+        }
+    }
+
+    void interact([[maybe_unused]] float_t x, const Vector& q, const size_t central, Vector& a) final
+    {
+        a.resize(q.size());
+        m_interaction.assign(masses(), masses() + m_bodies.size());
+        m_interaction[central] = 0.F;
+        gravity([&q](size_t i, size_t k) { return q[i * 3U + k]; }, m_interaction.data(), [&a](size_t i, const float_t* acceleration) { std::copy(acceleration, acceleration + 3, &a[i * 3U]); });
+    }
+
+    Vector getParams() const final
+    {
+        Vector y{};
+        getParams(y);
+        return y;
+    }
+
+    void getParams(Vector& y) const final
+    {
+        y.resize(m_bodies.size() * 6U);
+
+        uint32_t i{0U};
+        for (auto& body : m_bodies)
+        {
+            // Position
+            y[i++] = body.position[0];
+            y[i++] = body.position[1];
+            y[i++] = body.position[2];
+
+            // Velocity
+            y[i++] = body.velocity[0];
+            y[i++] = body.velocity[1];
+            y[i++] = body.velocity[2];
+        }
+    }
+
+    void setParams(const Vector& y) final
+    {
+        if (y.size() == m_bodies.size() * 6U)
+        {
+            uint32_t i{0U};
+            for (auto& body : m_bodies)
+            {
+                // Position
+                body.position[0] += y[i++];
+                body.position[1] += y[i++];
+                body.position[2] += y[i++];
+
+                // Velocity
+                body.velocity[0] += y[i++];
+                body.velocity[1] += y[i++];
+                body.velocity[2] += y[i++];
+            }
+        }
+    }
+    
+private:
+    /**
+     * Number of written bodies
+     */
+    [[nodiscard]] size_t selected() const
+    {
+        const size_t first{std::min(m_outputFirst, m_bodies.size())};
+        return m_outputCount == 0U ? m_bodies.size() - first : std::min(m_outputCount, m_bodies.size() - first);
+    }
+
+    /**
+     * Update and return the cached masses of the bodies
+     */
+    const float_t* masses()
+    {
+        m_mass.resize(m_bodies.size());
+        for (size_t i{0U}; i < m_bodies.size(); ++i)
+        {
+            m_mass[i] = m_bodies[i].mass;
+        }
+        return m_mass.data();
+    }
+
+    /**
+     * Calculate the accelerations of all bodies by the octree or the direct sum
+     * @param position   Function returning the coordinate k of body i as position(i, k)
+     * @param mass       Masses of the bodies
+     * @param store      Function called as store(i, acceleration) with the three components of body i
+     */
+    template<typename P, typename S>
+    void gravity(P&& position, const float_t* mass, S&& store)
+    {
+        const size_t count{m_bodies.size()};
+        m_evaluations += count;
+        if (m_theta > 0.F)
+        {
+            m_octree.build(count, position, mass, *m_pool);
+            m_octree.accelerations(store, *m_pool);
+            return;
+        }
+        m_direct.accelerations(count, position, mass, store, *m_pool);
+    }
+
+    /**
+     * Calculate the accelerations of the listed bodies by the octree or the direct sum
+     * @param position   Function returning the coordinate k of body i as position(i, k)
+     * @param mass       Masses of the bodies
+     * @param active     Bodies, whose accelerations are calculated
+     * @param actives    Number of listed bodies
+     * @param store      Function called as store(i, acceleration) with the three components of body i
+     */
+    template<typename P, typename S>
+    void gravity(P&& position, const float_t* mass, const size_t* active, const size_t actives, S&& store)
+    {
+        const size_t count{m_bodies.size()};
+        m_evaluations += actives;
+        if (m_theta > 0.F)
+        {
+            m_octree.build(count, position, mass, *m_pool);
+            m_octree.accelerations(active, actives, store, *m_pool);
+            return;
+        }
+        m_direct.accelerations(count, position, mass, active, actives, store, *m_pool);
+    }
+
+    static constexpr uint32_t CHECKPOINT{0x5044U}; //!< Kind of the checkpoint state
+
+    std::vector<Body> m_bodies{};
+    std::vector<float_t> m_mass{}; //!< Masses of the bodies
+    std::vector<float_t> m_interaction{}; //!< Masses without the central body
+    Integrator m_integrator{Integrator::RungeKutta};
+    RungeKutta m_solver{};
+    ode::Workspace<float_t> m_workspace{}; //!< Reused buffers of the Runge Kutta steps
+    Leapfrog m_leapfrog{};
+    Yoshida4 m_yoshida{};
+    WisdomHolman m_wisdomHolman{};
+    BlockTimesteps m_blocks{};
+    Vector m_positions{}; //!< Positions of the block time steps
+    Vector m_velocities{}; //!< Velocities of the block time steps
+    size_t m_evaluations{0U}; //!< Number of calculated accelerations of single bodies
+    DirectSum m_direct{}; //!< Exact forces of all pairs
+    Octree m_octree{}; //!< Barnes Hut forces
+    float_t m_theta{0.F}; //!< Opening angle, zero for the forces of all pairs
+    std::unique_ptr<ode::ThreadPool> m_pool{std::make_unique<ode::ThreadPool>()};
+    FrameWriter m_writer{};
+    bool m_binary{false}; //!< Binary trajectory output
+    float_t m_timeStep{0.F}; //!< Time step of the binary trajectory
+    size_t m_stride{1U}; //!< Steps between written frames
+    size_t m_outputFirst{0U}; //!< First written body
+    size_t m_outputCount{0U}; //!< Number of written bodies, zero for all from the first
+    bool m_split{false}; //!< Split the trajectory into a file per body at the end
+    float_t m_time{0.F}; //!< Time of the current frame
+    size_t m_frames{0U};
+    float_t m_rangeX[2]{};
+    float_t m_rangeY[2]{};
+    ode::CheckpointWriter m_checkpoints{};
+    size_t m_checkpointInterval{0U}; //!< Steps between checkpoints
+    std::string m_checkpointFile{}; //!< Checkpoint file
+};
+}
@@ -1,199 +1,9 @@
-
-#include "ode/RungeKutta.h"
-#include <algorithm>
+#include "World.h"
 #include <atomic>
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <thread>
 
-using Vector = ode::Vector<float_t>;
-using Function = ode::Function<float_t>;
-using RungeKutta = ode::RungeKutta<float_t>;
-
-/**
- * Body class
- */
-class Body
-{
-public:
-    Body()
-         : position(3U)
-         , velocity(3U)
-    {
-    }
-    std::string name{}; //!< Planet name
-    Vector position{}; //!< Position vector
-    Vector velocity{}; //!< Velocity vector
-    float_t radius{0.F}; //!< Radius
-    float_t mass{0.F}; //!< Mass
-    std::ofstream file{}; //!< Output stream
-};
-
-/**
- * World class
- */
-class World : public Function
-{
-public:
-    World() = default;
-
-    void step(const float_t t, const float_t dt)
-    {
-        // Calculate new values
-        m_solver.calc(t, dt, *this);
-
-        // Print results to files
-        print();
-    }
-
-    void print()
-    {
-        for (auto& body : m_bodies)
-        {
-            for (size_t i{0U}; i < 3U; ++i)
-            {
-                body.file << body.position[i] << (i > 2U ? "\n" : "\t");
-                m_plotfile << body.position[i] << "\t";
-            }
-
-            m_rangeX[0] = std::min(m_rangeX[0], body.position[0]);
-            m_rangeX[1] = std::min(m_rangeX[1], body.position[0]);
-            m_rangeY[0] = std::min(m_rangeY[0], body.position[1]);
-            m_rangeY[1] = std::min(m_rangeY[1], body.position[1]);
-        }
-        m_frames++;
-        m_plotfile << std::endl;
-    }
-
-    bool initialize(const std::string& filename)
-    {
-        std::ifstream file(filename, std::ios::in);
-        if (file.good())
-        {
-            uint32_t count{0U};
-            file >> count;
-            std::cout << "Number of bodies = " << count << std::endl;
-            m_bodies.resize(count);
-            for (uint32_t i{0U}; i < count; ++i)
-            {
-                file >> m_bodies[i].name;
-                file >> m_bodies[i].position[0];
-                file >> m_bodies[i].velocity[1];
-                file >> m_bodies[i].mass;
-                file >> m_bodies[i].radius;
-                std::cout << m_bodies[i].name << " d=" << m_bodies[i].position[0] << " v=" << m_bodies[i].velocity[1] << " m=" << m_bodies[i].mass << " r=" << m_bodies[i].radius << std::endl;
-                m_bodies[i].file.open(m_bodies[i].name + ".dat", std::ios::out | std::ios::trunc);
-            }
-            m_plotfile.open("Solarsystem.dat", std::ios::out | std::ios::trunc);
-            return true;
-        }
-        std::cout << "Invalid file " << filename.c_str() << std::endl;
-        return false;
-    }
-
-    void finish()
-    {
-        for (auto& body : m_bodies)
-        {
-            body.file.close();
-        }
-        m_plotfile.close();
-        std::cout << "Range = [" << m_rangeX[0] << ":" << m_rangeX[1] << ", " << m_rangeY[0] << ":" << m_rangeY[1] << "]" << std::endl;
-        std::cout << "Frames = " << m_frames << std::endl;
-    }
-
-protected:
-    Vector derive(float_t x, Vector& y) final
-    {
-        const size_t size = m_bodies.size() * 6U;
-        Vector dydx(size);
-
-        for (uint32_t a{0U}; a < size; a += 6U)
-        {
-            for (uint32_t k{0U}; k < 3; ++k)
-            {
-                // Position
-                dydx[a + k] = y[a + k + 3];
-                // Velocity
-                dydx[a + k + 3] = 0.F;
-            }
-
-            for (uint32_t b{0U}; b < size; b += 6)
-            {
-                if (a != b)
-                {
-                    // Mass
-                    std::vector<Body>::iterator it = m_bodies.begin();
-                    it += (b / 6);
-                    float_t m = it->mass;
-                    // Distance
-                    float_t d{0.F};
-                    for (uint32_t k{0U}; k < 3; ++k)
-                    {
-                        d += std::pow(y[a + k] - y[b + k], 2.F);
-                    }
-                    d = std::sqrt(d);
-                    // Velocity
-                    for (uint32_t k{0U}; k < 3; ++k)
-                    {
-                        dydx[a + k + 3] += (y[b + k] - y[a + k]) * m / std::pow(d, 3.F);
-                    }
-                }
-            }
-        }
-        return dydx;
-    }
-
-    Vector getParams() const final
-    {
-        Vector y(m_bodies.size() * 6U);
-
-        uint32_t i{0U};
-        for (auto& body : m_bodies)
-        {
-            // Position
-            y[i++] = body.position[0];
-            y[i++] = body.position[1];
-            y[i++] = body.position[2];
-
-            // Velocity
-            y[i++] = body.velocity[0];
-            y[i++] = body.velocity[1];
-            y[i++] = body.velocity[2];
-        }
-        return y;
-    }
-
-    void setParams(const Vector& y) final
-    {
-        if (y.size() == m_bodies.size() * 6U)
-        {
-            uint32_t i{0U};
-            for (auto& body : m_bodies)
-            {
-                // Position
-                body.position[0] += y[i++];
-                body.position[1] += y[i++];
-                body.position[2] += y[i++];
-
-                // Velocity
-                body.velocity[0] += y[i++];
-                body.velocity[1] += y[i++];
-                body.velocity[2] += y[i++];
-            }
-        }
-    }
-    
-private:
-    std::vector<Body> m_bodies{};
-    RungeKutta m_solver{};
-    std::ofstream m_plotfile{};
-    size_t m_frames{0U};
-    float_t m_rangeX[2];
-    float_t m_rangeY[2];
-};
-
 /**
  * Console class
  */
@@ -222,21 +32,111 @@ public:
 int main(int argc, char** argv)
 {
     std::string filename{};
-    if (argc >= 2)
+    std::string output{};
+    bool binary{false};
+    size_t stride{1U};
+    size_t first{0U};
+    size_t count{0U};
+    bool split{false};
+    size_t checkpoint{0U};
+    std::string restart{};
+    size_t threads{0U};
+    float_t theta{0.F};
+    bool vectorized{true};
+    std::string integrator{};
+    float_t dt{0.001F};
+    float_t eta{0.02F};
+    size_t levels{16U};
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--format" && i + 1 < argc)
+        {
+            binary = std::string{argv[++i]} == "binary";
+        }
+        else if (argument == "--stride" && i + 1 < argc)
+        {
+            stride = std::stoul(argv[++i]);
+        }
+        else if (argument == "--bodies" && i + 2 < argc)
+        {
+            first = std::stoul(argv[++i]);
+            count = std::stoul(argv[++i]);
+        }
+        else if (argument == "--split")
+        {
+            split = true;
+        }
+        else if (argument == "--checkpoint" && i + 1 < argc)
+        {
+            checkpoint = std::stoul(argv[++i]);
+        }
+        else if (argument == "--restart" && i + 1 < argc)
+        {
+            restart = argv[++i];
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            threads = std::stoul(argv[++i]);
+        }
+        else if (argument == "--integrator" && i + 1 < argc)
+        {
+            integrator = argv[++i];
+        }
+        else if (argument == "--dt" && i + 1 < argc)
+        {
+            dt = std::stof(argv[++i]);
+        }
+        else if (argument == "--eta" && i + 1 < argc)
+        {
+            eta = std::stof(argv[++i]);
+        }
+        else if (argument == "--levels" && i + 1 < argc)
+        {
+            levels = std::stoul(argv[++i]);
+        }
+        else if (argument == "--kernel" && i + 1 < argc)
+        {
+            vectorized = std::string{argv[++i]} != "scalar";
+        }
+        else if (argument == "--theta" && i + 1 < argc)
+        {
+            theta = std::stof(argv[++i]);
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            filename = argument;
+        }
+    }
+    if (!filename.empty() || !restart.empty())
     {
-        World world{};
-        if (world.initialize(argv[1]))
+        pd::World world{};
+        world.setOutputPolicy(pd::FrameWriter::toPolicy(output));
+        world.setBinaryOutput(binary, dt);
+        world.setOutput(stride, first, count, split);
+        world.setCheckpoint(checkpoint, "Solarsystem.chk");
+        world.setThreads(threads);
+        world.setTheta(theta);
+        world.setVectorized(vectorized);
+        world.setIntegrator(pd::World::toIntegrator(integrator));
+        world.setBlockTimesteps(eta, levels);
+        // The trajectory is written anew from the checkpoint on
+        const bool restored{!restart.empty() && world.restore(restart) && world.openOutput()};
+        if (restored || (restart.empty() && world.initialize(filename)))
         {
             Console console{};
             std::atomic<bool> run(true);
             std::thread console_t(console, std::ref(run));
 
-            float_t t{0.F};
-            static constexpr float_t dt{0.001F};
+            float_t t{world.time()};
             while (run.load())
             {
-                t += dt;
                 world.step(t, dt);
+                t += dt;
             }
             world.finish();
             run.store(false);
@@ -1,15 +1,74 @@
+#include "moleculardynamics/Domains.h"
+#include "moleculardynamics/Generator.h"
+#include "moleculardynamics/LennardJones.h"
+#include "moleculardynamics/World.h"
+#include "ode/Checkpoint.h"
+#include "ode/DormandPrince.h"
+#include "ode/EnsembleRungeKutta.h"
 #include "ode/Euler.h"
+#include "ode/FrameWriter.h"
 #include "ode/MidPoint.h"
 #include "ode/RungeKutta.h"
+#include "ode/TextReader.h"
+#include "ode/Trajectory.h"
+#include "ode/Symplectic.h"
+#include "ode/ThreadPool.h"
+#include "ode/VelocityVerlet.h"
+#include "planetdynamics/World.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <random>
 #include <string>
+#include <thread>
 
 using Vector = ode::Vector<float_t>;
 using Function = ode::Function<float_t>;
 using Euler = ode::Euler<float_t>;
 using MidPoint = ode::MidPoint<float_t>;
 using RungeKutta = ode::RungeKutta<float_t>;
+using DormandPrince = ode::DormandPrince<float_t>;
+using VelocityVerlet = ode::VelocityVerlet<float_t>;
+using Ensemble = ode::Ensemble<float_t>;
+using EnsembleFunction = ode::EnsembleFunction<float_t>;
+using EnsembleRungeKutta = ode::EnsembleRungeKutta<float_t>;
+using Solver = ode::Solver<float_t>;
+using Vector3 = ode::Vector<float_t, 3>;
+
+static_assert(sizeof(Vector3) == 3U * sizeof(float_t), "Fixed size vector must not have overhead");
+using Workspace = ode::Workspace<float_t>;
+
+// Heap allocation counter, the replacements aren't inlined so the compiler never pairs malloc and free with new and delete
+static size_t allocations{0U};
+
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    ++allocations;
+    // operator new(0) must return a unique pointer, malloc(0) may return null
+    if (void* ptr = std::malloc(size > 0U ? size : 1U))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, [[maybe_unused]] size_t size) noexcept
+{
+    std::free(ptr);
+}
 
 // Derivative of a function
 class Derivative : public Function
@@ -24,11 +83,32 @@ public:
     {
         return Vector{std::cos(x)};
     }
+
+    void derive(float_t x, [[maybe_unused]] Vector& y, Vector& dydx) final
+    {
+        dydx[0u] = std::cos(x);
+    }
+
+    Vector derive2(float_t x, [[maybe_unused]] Vector& y, [[maybe_unused]] Vector& dy) final
+    {
+        return Vector{-std::sin(x)};
+    }
+
+    void derive2(float_t x, [[maybe_unused]] Vector& y, [[maybe_unused]] Vector& dy, Vector& dyd2x) final
+    {
+        dyd2x[0u] = -std::sin(x);
+    }
     
     Vector getParams() const final
     {
         return m_data;
     }
+
+    void getParams(Vector& y) const final
+    {
+        y.resize(m_data.size());
+        y[0u] = m_data[0u];
+    }
     
     void setParams(const Vector& y) final
     {
@@ -39,6 +119,307 @@ private:
     Vector m_data;
 };
 
+// Derivative of a function with fixed size parameters
+class FixedDerivative : public ode::Function<float_t, 1>
+{
+public:
+    using Vector1 = ode::Vector<float_t, 1>;
+
+    Vector1 derive(float_t x, [[maybe_unused]] Vector1& y) final
+    {
+        return Vector1{std::cos(x)};
+    }
+
+    Vector1 getParams() const final
+    {
+        return m_data;
+    }
+
+    void setParams(const Vector1& y) final
+    {
+        m_data += y;
+    }
+
+private:
+    Vector1 m_data{};
+};
+
+// Derivatives of shifted functions, large enough for the vectorized kernels
+class Derivatives : public Function
+{
+public:
+    Derivatives()
+        : m_data(ode::simd::THRESHOLD + 3U)
+    {
+    }
+
+    Vector derive(float_t x, [[maybe_unused]] Vector& y) final
+    {
+        Vector dydx(m_data.size());
+        for (size_t i{0U}; i < dydx.size(); ++i)
+        {
+            dydx[i] = std::cos(x + static_cast<float_t>(i));
+        }
+        return dydx;
+    }
+
+    Vector getParams() const final
+    {
+        return m_data;
+    }
+
+    void setParams(const Vector& y) final
+    {
+        m_data.axpy(1.F, y);
+    }
+
+private:
+    Vector m_data;
+};
+
+// Derivative of a function without virtual methods
+class StaticDerivative
+{
+public:
+    void derive(float_t x, [[maybe_unused]] Vector& y, Vector& dydx)
+    {
+        dydx[0u] = std::cos(x);
+    }
+
+    void getParams(Vector& y) const
+    {
+        y = m_data;
+    }
+
+    void setParams(const Vector& y)
+    {
+        m_data += y;
+    }
+
+    Vector m_data{0.F};
+};
+
+// Exponential function y' = y
+class Exponential : public ode::Function<double_t, 1>
+{
+public:
+    using Vector1 = ode::Vector<double_t, 1>;
+
+    Vector1 derive([[maybe_unused]] double_t x, Vector1& y) final
+    {
+        return y;
+    }
+
+    Vector1 getParams() const final
+    {
+        return m_data;
+    }
+
+    void setParams(const Vector1& y) final
+    {
+        m_data += y;
+    }
+
+private:
+    Vector1 m_data{1.};
+};
+
+// Function y' = y^2 with y(0) = 1, whose solution 1 / (1 - x) has a pole at x = 1
+class Pole : public ode::Function<double_t, 1>
+{
+    using Vector1 = ode::Vector<double_t, 1>;
+
+public:
+    Vector1 derive([[maybe_unused]] double_t x, Vector1& y) final
+    {
+        return y * y[0u];
+    }
+
+    Vector1 getParams() const final
+    {
+        return m_data;
+    }
+
+    void setParams(const Vector1& y) final
+    {
+        m_data += y;
+    }
+
+private:
+    Vector1 m_data{1.};
+};
+
+// Derivative that isn't a number beyond x = 1
+class NotANumber : public ode::Function<double_t, 1>
+{
+    using Vector1 = ode::Vector<double_t, 1>;
+
+public:
+    Vector1 derive(double_t x, [[maybe_unused]] Vector1& y) final
+    {
+        return Vector1{x > 1. ? std::numeric_limits<double_t>::quiet_NaN() : 1.};
+    }
+
+    Vector1 getParams() const final
+    {
+        return m_data;
+    }
+
+    void setParams(const Vector1& y) final
+    {
+        m_data += y;
+    }
+
+private:
+    Vector1 m_data{0.};
+};
+
+// Check the convergence order of a Butcher tableau
+template<typename Tableau>
+bool checkOrder(const char* name)
+{
+    auto error = [](const size_t steps) {
+        ode::ExplicitRungeKutta<double_t, Tableau, 1> solver{};
+        ode::Workspace<double_t, 1> workspace{};
+        Exponential y{};
+        const double_t dx{1. / static_cast<double_t>(steps)};
+        for (size_t i{0U}; i < steps; ++i)
+        {
+            solver.step(static_cast<double_t>(i) * dx, dx, y, workspace);
+        }
+        return std::abs(y.getParams()[0u] - std::exp(1.));
+    };
+    const double_t ratio{error(20U) / error(40U)};
+    const double_t expected{std::pow(2., static_cast<double_t>(Tableau::ORDER))};
+    if (ratio < 0.8 * expected)
+    {
+        std::cerr << "Mismatch order of " << name << " error ratio " << ratio << " < " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Harmonic oscillators y'' = -y
+class Oscillators : public EnsembleFunction
+{
+public:
+    void derive([[maybe_unused]] float_t x, const Ensemble& y, Ensemble& dydx) final
+    {
+        for (size_t i{0U}; i < y.count(); ++i)
+        {
+            dydx(0u, i) = y(1u, i);
+            dydx(1u, i) = -y(0u, i);
+        }
+    }
+};
+
+// Harmonic oscillator q'' = -q split into position and velocity
+class SplitOscillator : public ode::SplitFunction<double_t, 1>
+{
+public:
+    void getState(ode::Vector<double_t, 1>& q, ode::Vector<double_t, 1>& v) const final
+    {
+        q = m_q;
+        v = m_v;
+    }
+
+    void setState(const ode::Vector<double_t, 1>& q, const ode::Vector<double_t, 1>& v) final
+    {
+        m_q = q;
+        m_v = v;
+    }
+
+    void accelerate([[maybe_unused]] double_t x, const ode::Vector<double_t, 1>& q, ode::Vector<double_t, 1>& a) final
+    {
+        a[0u] = -q[0u];
+    }
+
+    ode::Vector<double_t, 1> m_q{0.};
+    ode::Vector<double_t, 1> m_v{1.};
+};
+
+// Check the convergence order of a symplectic composition
+template<typename Coefficients>
+bool checkSymplecticOrder(const char* name)
+{
+    auto error = [](const size_t steps) {
+        ode::Symplectic<double_t, Coefficients, 1> solver{};
+        ode::Workspace<double_t, 1> workspace{};
+        SplitOscillator y{};
+        const double_t dx{1. / static_cast<double_t>(steps)};
+        for (size_t i{0U}; i < steps; ++i)
+        {
+            solver.step(static_cast<double_t>(i) * dx, dx, y, workspace);
+        }
+        return std::abs(y.m_q[0u] - std::sin(1.));
+    };
+    const double_t ratio{error(20U) / error(40U)};
+    const double_t expected{std::pow(2., static_cast<double_t>(Coefficients::ORDER))};
+    if (ratio < 0.8 * expected)
+    {
+        std::cerr << "Mismatch order of " << name << " error ratio " << ratio << " < " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Compare the kernels of all supported instruction sets with the scalar ones
+bool checkKernels()
+{
+    using ode::simd::Isa;
+    bool result{true};
+    const auto& scalar = ode::simd::kernels<float_t>(Isa::Scalar);
+    for (const Isa isa : {Isa::Sse2, Isa::Avx2, Isa::Avx512})
+    {
+        if (!ode::simd::supported(isa))
+        {
+            continue;
+        }
+        const auto& kernels = ode::simd::kernels<float_t>(isa);
+        for (size_t size{0U}; size < 70U; ++size)
+        {
+            Vector x(size);
+            Vector y(size);
+            for (size_t i{0U}; i < size; ++i)
+            {
+                x[i] = static_cast<float_t>(i % 7U) - 3.5F;
+                y[i] = 1.F / static_cast<float_t>(i + 1U);
+            }
+            const float_t e{1e-4F * static_cast<float_t>(size + 1U)};
+            const float_t* k[]{x.data(), y.data()};
+            const float_t w[]{0.5F, -2.F};
+            Vector out1(size);
+            Vector out2(size);
+            scalar.combine(out1.data(), y.data(), 0.1F, k, w, 2U, size);
+            kernels.combine(out2.data(), y.data(), 0.1F, k, w, 2U, size);
+            Vector axpy1{y};
+            Vector axpy2{y};
+            scalar.axpy(3.F, x.data(), axpy1.data(), size);
+            kernels.axpy(3.F, x.data(), axpy2.data(), size);
+            if (!ode::equal(scalar.dot(x.data(), y.data(), size), kernels.dot(x.data(), y.data(), size), e) ||
+                !ode::equal(scalar.norm1(x.data(), size), kernels.norm1(x.data(), size), e) ||
+                !ode::equal(scalar.sumSquares(x.data(), size), kernels.sumSquares(x.data(), size), e) ||
+                !ode::equal(scalar.normInf(x.data(), size), kernels.normInf(x.data(), size)) ||
+                !ode::equal(Vector{out1 - out2}.normInf(), 0.F, e) ||
+                !ode::equal(Vector{axpy1 - axpy2}.normInf(), 0.F, e))
+            {
+                result = false;
+                std::cerr << "Mismatch kernel " << static_cast<int>(isa) << " size " << size << std::endl;
+            }
+            if (size > 0U)
+            {
+                x[size / 2U] = std::nanf("");
+                if (!std::isnan(kernels.normInf(x.data(), size)))
+                {
+                    result = false;
+                    std::cerr << "Mismatch kernel " << static_cast<int>(isa) << " normInf(NaN) size " << size << std::endl;
+                }
+            }
+        }
+    }
+    return result;
+}
+
 // Main funtion
 int main(int argc, char** argv)
 {
@@ -90,5 +471,1386 @@ int main(int argc, char** argv)
         }
     }
 
+    // Vector expressions
+    {
+        const Vector a{1.F, 2.F, 3.F};
+        Vector b{a * 2.F - 1.F};
+        b += a / 2.F + -a;
+        b *= 2.F;
+        const Vector c{2.F * (b - a) + 1.F};
+        const Vector expected{1.F, 5.F, 9.F};
+        for (size_t i{0U}; i < expected.size(); ++i)
+        {
+            if (!ode::equal(c[i], expected[i]))
+            {
+                errors = true;
+                std::cerr << "Mismatch Vector expression[" << i << "]=" << c[i] << " != " << expected[i] << std::endl;
+            }
+        }
+
+        // The evaluation of expressions must not hide std::vector::assign
+        Vector d{};
+        d.assign(2U, 1.F);
+        d.assign(c.begin(), c.end());
+        if (d.size() != c.size() || !std::equal(d.begin(), d.end(), c.begin()))
+        {
+            errors = true;
+            std::cerr << "Mismatch Vector assign size=" << d.size() << std::endl;
+        }
+    }
+
+    // Vectorized kernels
+    errors |= !checkKernels();
+
+    // Large parameter vectors y[i](x)=sin(x+i)-sin(i)
+    {
+        Derivatives y9{};
+        for (float_t t{0.0F}; t < 1.F - dt / 2.F; t += dt)
+        {
+            rk.calc(t, dt, y9);
+        }
+        const Vector y{y9.getParams()};
+        for (size_t i{0U}; i < y.size(); ++i)
+        {
+            const float_t expected{std::sin(1.F + static_cast<float_t>(i)) - std::sin(static_cast<float_t>(i))};
+            if (!ode::equal(y[i], expected, e))
+            {
+                errors = true;
+                std::cerr << "Mismatch large RungeKutta[" << i << "](1)=" << y[i] << " != " << expected << std::endl;
+            }
+        }
+    }
+
+    // Butcher tableaus
+    errors |= !checkOrder<ode::tableau::Euler>("Euler");
+    errors |= !checkOrder<ode::tableau::Heun>("Heun");
+    errors |= !checkOrder<ode::tableau::MidPoint>("MidPoint");
+    errors |= !checkOrder<ode::tableau::Ralston>("Ralston");
+    errors |= !checkOrder<ode::tableau::BogackiShampine>("BogackiShampine");
+    errors |= !checkOrder<ode::tableau::RungeKutta>("RungeKutta");
+    errors |= !checkOrder<ode::tableau::RungeKutta38>("RungeKutta38");
+    errors |= !checkSymplecticOrder<ode::composition::Leapfrog>("Leapfrog");
+    errors |= !checkSymplecticOrder<ode::composition::Yoshida4>("Yoshida4");
+
+    // Fixed size vectors
+    {
+        const Vector3 a{1.F, 2.F, 3.F};
+        const Vector3 b{a * 2.F - 1.F};
+        if (!ode::equal(a.dot(b), 22.F) || !ode::equal(b.norm(1), 9.F) || !ode::equal(Vector3{a - a}.length(), 0.F))
+        {
+            errors = true;
+            std::cerr << "Mismatch fixed size Vector" << std::endl;
+        }
+
+        ode::RungeKutta<float_t, 1> frk{};
+        ode::Workspace<float_t, 1> workspace6{};
+        FixedDerivative y6{};
+        for (float_t t{0.0F}; t < 1.F - dt / 2.F; t += dt)
+        {
+            frk.step(t, dt, y6, workspace6);
+        }
+        if (!ode::equal(y6.getParams()[0u], sinf(1.F), e))
+        {
+            errors = true;
+            std::cerr << "Mismatch fixed size RungeKutta(1)=" << y6.getParams()[0u] << " != " << sinf(1.F) << std::endl;
+        }
+    }
+
+    // Static dispatch
+    {
+        StaticDerivative y7{};
+        Derivative y8{};
+        Workspace workspace7{};
+        Workspace workspace8{};
+        for (float_t t{0.0F}; t < 1.F - dt / 2.F; t += dt)
+        {
+            rk.step(t, dt, y7, workspace7);
+            mp.step(t, dt, y8, workspace8);
+        }
+        if (!ode::equal(y7.m_data[0u], sinf(1.F), e) || !ode::equal(y8.getParams()[0u], sinf(1.F), e))
+        {
+            errors = true;
+            std::cerr << "Mismatch static step(1)=" << y7.m_data[0u] << ", " << y8.getParams()[0u] << " != " << sinf(1.F) << std::endl;
+        }
+    }
+
+    // Adaptive step size
+    {
+        DormandPrince dp{};
+        Derivative y5{};
+        dp.setTolerance(1e-6F, 1e-6F);
+        const Vector y{dp.calcRange(0.F, Vector{0.F}, 1.F, dt, y5)};
+        const auto& statistics = dp.statistics();
+        if (!ode::equal(y[0u], sinf(1.F), e) || !ode::equal(y5.getParams()[0u], sinf(1.F), e))
+        {
+            errors = true;
+            std::cerr << "Mismatch DormandPrince(1)=" << y[0u] << " != " << sinf(1.F) << std::endl;
+        }
+        if (statistics.accepted >= static_cast<size_t>(1.F / dt))
+        {
+            errors = true;
+            std::cerr << "DormandPrince accepted steps = " << statistics.accepted << std::endl;
+        }
+        if (!silent)
+        {
+            std::cout << "DormandPrince accepted=" << statistics.accepted << " rejected=" << statistics.rejected << " evaluations=" << statistics.evaluations << std::endl;
+        }
+
+        // A single step beyond the tolerances is taken but not counted as accepted
+        ode::DormandPrince<double_t, 1> single{};
+        Exponential exponential{};
+        single.calc(0., 2., exponential);
+        if (single.statistics().accepted != 0U || single.statistics().rejected != 1U || single.statistics().underflow)
+        {
+            errors = true;
+            std::cerr << "Mismatch DormandPrince single step accepted=" << single.statistics().accepted << " rejected=" << single.statistics().rejected << std::endl;
+        }
+
+        // The step size underflows at the pole, the range ends before it
+        ode::DormandPrince<double_t, 1> pole{};
+        Pole function{};
+        const ode::Vector<double_t, 1> y0{1.};
+        const ode::Vector<double_t, 1> yp{pole.calcRange(0., y0, 2., 0.1, function)};
+        if (!pole.statistics().underflow || !(yp[0u] > 1e6) || !std::isfinite(yp[0u]))
+        {
+            errors = true;
+            std::cerr << "Mismatch DormandPrince underflow=" << pole.statistics().underflow << " y=" << yp[0u] << std::endl;
+        }
+
+        // A NaN error estimate ends the range instead of spinning forever
+        ode::DormandPrince<double_t, 1> nan{};
+        NotANumber notANumber{};
+        const ode::Vector<double_t, 1> yn{nan.calcRange(0., ode::Vector<double_t, 1>{0.}, 2., 0.1, notANumber)};
+        if (!nan.statistics().underflow || !ode::equal(yn[0u], 1., 1e-6))
+        {
+            errors = true;
+            std::cerr << "Mismatch DormandPrince NaN underflow=" << nan.statistics().underflow << " y=" << yn[0u] << std::endl;
+        }
+    }
+
+    // Dense output sampled at fixed intervals
+    {
+        size_t samples{0U};
+        auto check = [&](const char* name, float_t x, const Vector& y) {
+            if (!ode::equal(y[0u], sinf(x), e))
+            {
+                errors = true;
+                std::cerr << "Mismatch dense " << name << "(" << x << ")=" << y[0u] << " != " << sinf(x) << std::endl;
+            }
+            ++samples;
+        };
+        DormandPrince dp{};
+        Derivative y9{};
+        dp.setTolerance(1e-6F, 1e-6F);
+        dp.stepRange(0.F, Vector{0.F}, 1.F, dt, y9, 0.1F, [&](float_t x, const Vector& y) { check("DormandPrince", x, y); });
+        RungeKutta rk{};
+        Derivative y10{};
+        rk.stepRange(0.F, Vector{0.F}, 1.F, 0.1F, y10, 0.05F, [&](float_t x, const Vector& y) { check("RungeKutta", x, y); });
+        if (samples != 11U + 21U)
+        {
+            errors = true;
+            std::cerr << "Dense output samples = " << samples << std::endl;
+        }
+    }
+
+    // Ensemble of y(x)=i*sin(x)
+    {
+        static constexpr size_t count{37U};
+        EnsembleRungeKutta erk{};
+        Oscillators oscillators{};
+        Ensemble y(2u, count);
+        for (size_t i{0U}; i < count; ++i)
+        {
+            y(1u, i) = static_cast<float_t>(i);
+        }
+        for (float_t t{0.0F}; t < 1.F - dt / 2.F; t += dt)
+        {
+            erk.calc(t, dt, oscillators, y);
+        }
+        for (size_t i{0U}; i < count; ++i)
+        {
+            const float_t expected{static_cast<float_t>(i) * sinf(1.F)};
+            if (!ode::equal(y(0u, i), expected, e * static_cast<float_t>(i + 1U)))
+            {
+                errors = true;
+                std::cerr << "Mismatch Ensemble[" << i << "](1)=" << y(0u, i) << " != " << expected << std::endl;
+            }
+        }
+    }
+
+    // Thread pool
+    {
+        static constexpr size_t count{10000U};
+        ode::ThreadPool pool{4U};
+        std::vector<size_t> sums(pool.size(), 0U);
+        pool.parallelFor(count, 64U, [&](size_t thread, size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i)
+            {
+                sums[thread] += i;
+            }
+        });
+        size_t sum{0U};
+        for (const size_t s : sums)
+        {
+            sum += s;
+        }
+        if (sum != count * (count - 1U) / 2U)
+        {
+            errors = true;
+            std::cerr << "Mismatch ThreadPool sum=" << sum << std::endl;
+        }
+    }
+
+    // Vectorized Lennard Jones kernel
+    {
+        static constexpr size_t count{500U};
+        std::mt19937 generator{1U};
+        std::uniform_real_distribution<float_t> distribution{0.F, 400.F};
+        std::vector<float_t> positions(3U * count);
+        for (auto& position : positions)
+        {
+            position = distribution(generator);
+        }
+        const float_t* position[3]{positions.data(), positions.data() + count, positions.data() + 2U * count};
+        md::NeighborList neighbors{};
+        neighbors.update(count, [&](size_t i, size_t k) { return position[k][i]; });
+        const md::lj::Parameters parameters{};
+        std::vector<float_t> forces[2]{std::vector<float_t>(3U * count, 0.F), std::vector<float_t>(3U * count, 0.F)};
+        md::lj::Sums sums[2]{};
+        for (size_t v{0U}; v < 2U; ++v)
+        {
+            float_t* force[3]{forces[v].data(), forces[v].data() + count, forces[v].data() + 2U * count};
+            sums[v] = md::lj::kernel(v == 1U)(parameters, neighbors, 0U, count, position, force);
+        }
+        float_t scale{0.F};
+        float_t difference{0.F};
+        for (size_t i{0U}; i < 3U * count; ++i)
+        {
+            scale = std::max(scale, std::abs(forces[0][i]));
+            difference = std::max(difference, std::abs(forces[0][i] - forces[1][i]));
+        }
+        if (difference > 1e-5F * scale || !ode::equal(sums[0].potential, sums[1].potential, 1e-5F * std::abs(sums[0].potential)) || !ode::equal(sums[0].virial, sums[1].virial, 1e-5F * std::abs(sums[0].virial)))
+        {
+            errors = true;
+            std::cerr << "Mismatch Lennard Jones kernel force=" << difference << " / " << scale << " potential=" << sums[1].potential << " != " << sums[0].potential << std::endl;
+        }
+    }
+
+    // Neighbor list forces against the forces of all pairs
+    {
+        static constexpr size_t count{600U};
+        static constexpr float_t side{400.F};
+        for (const bool periodic : {false, true})
+        {
+            std::mt19937 generator{3U};
+            std::uniform_real_distribution<float_t> distribution{0.F, side};
+            std::uniform_real_distribution<float_t> jitter{-2.F, 2.F};
+            std::vector<float_t> positions(3U * count);
+            for (auto& position : positions)
+            {
+                position = distribution(generator);
+            }
+            const float_t* position[3]{positions.data(), positions.data() + count, positions.data() + 2U * count};
+            md::lj::Parameters parameters{};
+            md::NeighborList neighbors{};
+            if (periodic)
+            {
+                const float_t box[3]{side, side, side};
+                neighbors.setBox(box);
+                std::fill(parameters.box, parameters.box + 3, side);
+            }
+            for (size_t pass{0U}; pass < 2U; ++pass)
+            {
+                // The second pass moves the particles less than half the skin, which keeps the list
+                if (pass == 1U)
+                {
+                    std::for_each(positions.begin(), positions.end(), [&](float_t& r) { r += jitter(generator); });
+                }
+                neighbors.update(count, [&](size_t i, size_t k) { return position[k][i]; });
+                std::vector<double> expected(3U * count, 0.);
+                for (size_t i{0U}; i < count; ++i)
+                {
+                    for (size_t j{i + 1U}; j < count; ++j)
+                    {
+                        double d[3];
+                        double r2{0.};
+                        for (size_t k{0U}; k < 3U; ++k)
+                        {
+                            d[k] = static_cast<double>(position[k][i]) - position[k][j];
+                            d[k] -= periodic ? side * std::nearbyint(d[k] / side) : 0.;
+                            r2 += d[k] * d[k];
+                        }
+                        if (r2 < parameters.cutoff2)
+                        {
+                            const double rho3{std::pow(parameters.sigma2 / r2, 3.)};
+                            const double f{24. * parameters.epsilon * (2. * rho3 - 1.) * rho3 / r2};
+                            for (size_t k{0U}; k < 3U; ++k)
+                            {
+                                expected[k * count + i] += f * d[k];
+                                expected[k * count + j] -= f * d[k];
+                            }
+                        }
+                    }
+                }
+                std::vector<float_t> forces(3U * count, 0.F);
+                float_t* force[3]{forces.data(), forces.data() + count, forces.data() + 2U * count};
+                md::lj::kernel(false, periodic)(parameters, neighbors, 0U, count, position, force);
+                double scale{0.};
+                double difference{0.};
+                for (size_t i{0U}; i < 3U * count; ++i)
+                {
+                    scale = std::max(scale, std::abs(expected[i]));
+                    difference = std::max(difference, std::abs(expected[i] - forces[i]));
+                }
+                if (difference > 1e-4 * scale || neighbors.builds() != 1U)
+                {
+                    errors = true;
+                    std::cerr << "Mismatch neighbor list forces periodic=" << periodic << " pass=" << pass << " force=" << difference << " / " << scale << " builds=" << neighbors.builds() << std::endl;
+                }
+            }
+        }
+
+        // Huge and infinite extents fall back to single cells
+        const float_t positions[3][3]{{0.F, 1e30F, std::numeric_limits<float_t>::infinity()}, {0.F, -1e30F, 1.F}, {0.F, 1.F, 2.F}};
+        md::NeighborList neighbors{};
+        neighbors.update(3U, [&](size_t i, size_t k) { return positions[k][i]; });
+        if (neighbors.size() > 3U)
+        {
+            errors = true;
+            std::cerr << "Mismatch neighbor list of infinite extent size=" << neighbors.size() << std::endl;
+        }
+    }
+
+    // Asynchronous frame writer
+    {
+        static constexpr size_t frames{100U};
+        const std::string filename{"FrameWriter.dat"};
+        {
+            ode::FrameWriter<float_t> writer{4U};
+            writer.open(filename, 1U, 2U);
+            for (size_t i{0U}; i < frames; ++i)
+            {
+                writer.push(static_cast<double>(i), 3U, [i](float_t* values) {
+                    values[0] = 0.F;
+                    values[1] = static_cast<float_t>(i);
+                    values[2] = 0.5F;
+                });
+            }
+            if (writer.open(filename + ".late", 0U, 1U) || writer.openBinary(filename + ".late", 0U, 3U, 3U, 1.))
+            {
+                errors = true;
+                std::cerr << "Mismatch FrameWriter output added after the first push" << std::endl;
+            }
+        }
+        std::ifstream file{filename};
+        std::string line{};
+        size_t rows{0U};
+        while (std::getline(file, line))
+        {
+            if (line != std::to_string(rows) + "\t0.5\t")
+            {
+                break;
+            }
+            ++rows;
+        }
+        if (rows != frames)
+        {
+            errors = true;
+            std::cerr << "Mismatch FrameWriter rows=" << rows << " line=" << line << std::endl;
+        }
+        file.close();
+
+        // Every 3rd frame continued after 2 frames written before
+        {
+            ode::FrameWriter<float_t> writer{4U};
+            writer.setStride(3U, 2U);
+            writer.open(filename, 0U, 2U);
+            for (size_t i{2U}; i < frames; ++i)
+            {
+                writer.push(static_cast<double>(i), 2U, [i](float_t* values) {
+                    values[0] = static_cast<float_t>(i);
+                    values[1] = -1.25e-7F * static_cast<float_t>(i);
+                });
+            }
+        }
+        file.open(filename);
+        rows = 0U;
+        while (std::getline(file, line))
+        {
+            char expected[64];
+            std::snprintf(expected, sizeof(expected), "%g\t%g\t", static_cast<double>(rows * 3U + 3U), -1.25e-7 * static_cast<double>(rows * 3U + 3U));
+            if (line != expected)
+            {
+                break;
+            }
+            ++rows;
+        }
+        if (rows != frames / 3U)
+        {
+            errors = true;
+            std::cerr << "Mismatch FrameWriter stride rows=" << rows << " line=" << line << std::endl;
+        }
+        file.close();
+
+        // A failed output isn't added
+        {
+            ode::FrameWriter<float_t> writer{};
+            if (writer.open("missing/FrameWriter.dat", 0U, 1U) || writer.openBinary("missing/FrameWriter.trj", 0U, 3U, 3U, 1.) || writer.push(0., 1U, [](float_t* values) { values[0] = 0.F; }))
+            {
+                errors = true;
+                std::cerr << "Mismatch FrameWriter of a missing directory" << std::endl;
+            }
+        }
+
+        // A slow writer drops frames of a burst, decimation keeps dropping some after it
+        for (const auto policy : {ode::FrameWriter<float_t>::Policy::Drop, ode::FrameWriter<float_t>::Policy::Decimate})
+        {
+            static constexpr size_t burst{8U};
+            static constexpr size_t pushes{burst + 30U};
+            std::vector<bool> queued{};
+            size_t dropped{0U};
+            {
+                ode::FrameWriter<float_t> writer{2U, policy};
+                writer.open(filename, 0U, 1U << 15U);
+                for (size_t i{0U}; i < pushes; ++i)
+                {
+                    if (i >= burst)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                    queued.push_back(writer.push(static_cast<double>(i), 1U << 15U, [i](float_t* values) {
+                        std::fill(values, values + (1U << 15U), 0.F);
+                        values[0] = static_cast<float_t>(i);
+                    }));
+                }
+                dropped = writer.dropped();
+            }
+            file.open(filename);
+            std::vector<bool> written(pushes, false);
+            rows = 0U;
+            while (std::getline(file, line))
+            {
+                written[std::min<size_t>(std::stoul(line), pushes - 1U)] = true;
+                ++rows;
+            }
+            file.close();
+            const auto later = static_cast<size_t>(std::count(written.begin() + burst, written.end(), true));
+            const bool decimated{policy == ode::FrameWriter<float_t>::Policy::Decimate ? later < pushes - burst && std::all_of(written.end() - 10, written.end(), [](bool w) { return w; }) : later == pushes - burst};
+            if (written != queued || rows + dropped != pushes || dropped == 0U || !written[0] || !written[1] || !decimated)
+            {
+                errors = true;
+                std::cerr << "Mismatch FrameWriter policy=" << static_cast<int>(policy) << " rows=" << rows << " dropped=" << dropped << " after burst=" << later << std::endl;
+            }
+        }
+        std::remove(filename.c_str());
+    }
+
+    // Binary trajectory
+    {
+        static constexpr size_t frames{10U};
+        const std::string filename{"Trajectory.trj"};
+        {
+            ode::TrajectoryWriter<float_t> writer{};
+            writer.open(filename, 2U, 3U, 0.5);
+            for (size_t k{0U}; k < frames; ++k)
+            {
+                const float_t values[6]{static_cast<float_t>(k), 1.F, 2.F, 3.F, 4.F, -static_cast<float_t>(k)};
+                writer.write(0.5 * static_cast<double>(k), values);
+            }
+        }
+        ode::TrajectoryReader<float_t> reader{};
+        if (!reader.open(filename) || reader.frames() != frames || reader.particles() != 2U || reader.dimension() != 3U || reader.timeStep() != 0.5)
+        {
+            errors = true;
+            std::cerr << "Invalid trajectory frames=" << reader.frames() << std::endl;
+        }
+        else if (reader.variable(7U) != 3.5 || reader.frame(7U)[0] != 7.F || reader.frame(7U)[5] != -7.F)
+        {
+            errors = true;
+            std::cerr << "Mismatch trajectory frame 7 x=" << reader.variable(7U) << std::endl;
+        }
+
+        // An interrupted file without index and with a partial frame falls back to the complete frames
+        const std::string truncated{"Truncated.trj"};
+        {
+            std::ifstream input{filename, std::ios::binary};
+            std::string data{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+            ode::trajectory::Header header{};
+            std::memcpy(&header, data.data(), sizeof(header));
+            const size_t frameSize{static_cast<size_t>(ode::trajectory::frameSize(header))};
+            header.frames = 0U;
+            header.index = 0U;
+            std::memcpy(data.data(), &header, sizeof(header));
+            data.resize(sizeof(header) + 6U * frameSize + frameSize / 2U);
+            std::ofstream output{truncated, std::ios::binary | std::ios::trunc};
+            output.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        ode::TrajectoryReader<float_t> interrupted{};
+        if (!interrupted.open(truncated) || interrupted.frames() != 6U || interrupted.variable(5U) != 2.5 || interrupted.frame(5U)[0] != 5.F || interrupted.frame(5U)[5] != -5.F)
+        {
+            errors = true;
+            std::cerr << "Mismatch truncated trajectory frames=" << interrupted.frames() << std::endl;
+        }
+        interrupted.close();
+        std::remove(truncated.c_str());
+
+        // A corrupt index offset falls back to the frames before the index
+        const std::string corrupt{"Corrupt.trj"};
+        {
+            std::ifstream input{filename, std::ios::binary};
+            std::string data{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+            ode::trajectory::Header header{};
+            std::memcpy(&header, data.data(), sizeof(header));
+            const uint64_t offset{std::numeric_limits<uint64_t>::max() - 4U};
+            std::memcpy(data.data() + header.index + 3U * sizeof(uint64_t), &offset, sizeof(offset));
+            std::ofstream output{corrupt, std::ios::binary | std::ios::trunc};
+            output.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        ode::TrajectoryReader<float_t> corrupted{};
+        if (!corrupted.open(corrupt) || corrupted.frames() != frames || corrupted.variable(3U) != 1.5 || corrupted.frame(3U)[0] != 3.F)
+        {
+            errors = true;
+            std::cerr << "Mismatch corrupt trajectory frames=" << corrupted.frames() << std::endl;
+        }
+        corrupted.close();
+        std::remove(corrupt.c_str());
+
+        // A text file per particle
+        const size_t files{ode::split(reader, 0U, 5U, [](size_t i) { return "Trajectory." + std::to_string(i) + ".dat"; })};
+        std::ifstream file{"Trajectory.0.dat"};
+        std::string line{};
+        size_t rows{0U};
+        while (std::getline(file, line) && line == std::to_string(rows) + "\t1\t2\t")
+        {
+            ++rows;
+        }
+        if (files != 2U || rows != frames)
+        {
+            errors = true;
+            std::cerr << "Mismatch split trajectory files=" << files << " rows=" << rows << " line=" << line << std::endl;
+        }
+        file.close();
+        std::remove("Trajectory.0.dat");
+        std::remove("Trajectory.1.dat");
+        reader.close();
+        std::remove(filename.c_str());
+    }
+
+    // Checkpoint and restart
+    {
+        const std::string filename{"Checkpoint.chk"};
+        ode::Archive archive{};
+        archive.begin(1U);
+        archive.write(std::vector<float_t>{1.F, 2.F});
+        archive.write(std::string{"Earth"});
+        archive.save(filename);
+        std::vector<float_t> values{};
+        std::string name{};
+        if (!archive.load(filename, 1U) || !archive.read(values) || !archive.read(name) || values.size() != 2U || values[1] != 2.F || name != "Earth" || archive.load(filename, 2U))
+        {
+            errors = true;
+            std::cerr << "Mismatch archive round trip" << std::endl;
+        }
+
+        // A checkpoint into a missing directory is counted as failed
+        ode::CheckpointWriter writer{};
+        writer.save("Missing/Checkpoint.chk", 1U, [](ode::Archive& output) { output.write(1.F); });
+        writer.wait();
+        if (writer.failed() != 1U || writer.skipped() != 0U)
+        {
+            errors = true;
+            std::cerr << "Mismatch failed checkpoints=" << writer.failed() << std::endl;
+        }
+
+        // A restarted run of the parallel force calculation continues bit for bit
+        md::Particles particles{};
+        md::generate::lattice(particles, md::generate::Lattice::Fcc, 8U, 45.F, 1.F);
+        md::generate::maxwellBoltzmann(particles, 100.F, 7U);
+        const size_t count{particles.size()};
+        static constexpr float_t step{0.001F};
+        md::World original{};
+        original.setThreads(4U);
+        original.initialize(std::move(particles));
+        for (size_t k{0U}; k < 50U; ++k)
+        {
+            original.integrate(static_cast<float_t>(k) * step, step);
+        }
+        original.checkpoint(filename);
+        original.waitCheckpoints();
+        md::World restarted{};
+        restarted.setThreads(4U);
+        if (count <= 1024U || !restarted.restore(filename))
+        {
+            errors = true;
+        }
+        for (size_t k{50U}; k < 100U; ++k)
+        {
+            original.integrate(static_cast<float_t>(k) * step, step);
+            restarted.integrate(static_cast<float_t>(k) * step, step);
+        }
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            if (!std::equal(original.particles().position(k), original.particles().position(k) + count, restarted.particles().position(k)))
+            {
+                errors = true;
+                std::cerr << "Mismatch restarted positions of axis " << k << std::endl;
+            }
+        }
+        std::remove(filename.c_str());
+    }
+
+    // The first step starts with the forces of the initial positions
+    {
+        std::vector<md::Body> bodies(3U);
+        bodies[1].position = md::Vector3{42.F, 0.F, 0.F};
+        bodies[2].position = md::Vector3{0.F, 50.F, 10.F};
+        for (auto& body : bodies)
+        {
+            body.mass = 1.F;
+        }
+        static constexpr float_t step{0.001F};
+        md::World reference{};
+        reference.initialize(bodies);
+        reference.lennardJones();
+        md::VelocityVerlet{}.advance(0.F, step, reference.particles(), [&](float_t) { reference.lennardJones(); });
+        md::World world{};
+        md::World moved{};
+        world.initialize(bodies);
+        moved.initialize(md::Particles{reference.particles()});
+        moved.initialize(std::vector<md::Body>{bodies});
+        world.integrate(0.F, step);
+        moved.integrate(0.F, step);
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            const float_t* expected{reference.particles().velocity(k)};
+            if (!std::equal(expected, expected + bodies.size(), world.particles().velocity(k)) || !std::equal(expected, expected + bodies.size(), moved.particles().velocity(k)))
+            {
+                errors = true;
+                std::cerr << "Mismatch first step velocities of axis " << k << std::endl;
+            }
+        }
+    }
+
+    // Observables
+    {
+        md::Statistics statistics{};
+        for (const double value : {1., 2., 3., 4.})
+        {
+            statistics.add(value);
+        }
+        if (statistics.mean() != 2.5 || !ode::equal(statistics.variance(), 5. / 3., 1e-12))
+        {
+            errors = true;
+            std::cerr << "Mismatch statistics mean=" << statistics.mean() << " variance=" << statistics.variance() << std::endl;
+        }
+
+        // The potential energy of a resting pair must not accumulate over the steps
+        std::vector<md::Body> bodies(2U);
+        bodies[1].position = md::Vector3{45.F, 0.F, 0.F};
+        bodies[0].mass = bodies[1].mass = 1000.F;
+        md::World world{};
+        world.initialize(bodies);
+        for (size_t k{0U}; k < 10U; ++k)
+        {
+            world.integrate(static_cast<float_t>(k) * 1e-4F, 1e-4F);
+        }
+        const float_t rho6{std::pow(40.F / 45.F, 6.F)};
+        const float_t potential{4.F * 20.F * (rho6 - 1.F) * rho6};
+        const md::Observables& observables{world.observables()};
+        if (!ode::equal(observables.value(md::Observables::Potential), potential, 1e-3F * std::abs(potential)) || std::abs(observables.momentum(0U)) > 1e-3F || observables.statistics(md::Observables::Total).count() != 10U)
+        {
+            errors = true;
+            std::cerr << "Mismatch observables potential=" << observables.value(md::Observables::Potential) << " != " << potential << std::endl;
+        }
+    }
+
+    // Parallel text reader
+    {
+        static constexpr size_t count{100000U};
+        const std::string filename{"TextReader.dat"};
+        {
+            std::ofstream file{filename};
+            file.precision(10);
+            file << "Sun " << count << "\n";
+            for (size_t i{0U}; i < count; ++i)
+            {
+                file << (i % 2U == 0U ? "+" : "-") << static_cast<float_t>(i) * 0.25F << (i % 7U == 0U ? "\r\n" : "\t");
+            }
+            file << "Moon";
+        }
+        ode::ThreadPool pool{4U};
+        ode::TextReader<float_t> reader{};
+        std::string name{};
+        uint32_t size{0U};
+        std::vector<float_t> values(count);
+        if (!reader.open(filename) || !reader.read(name) || !reader.read(size) || !reader.read(values.data(), count, &pool) || !reader.read(name) || name != "Moon")
+        {
+            errors = true;
+            std::cerr << "Invalid text file " << filename << std::endl;
+        }
+        for (size_t i{0U}; i < count; ++i)
+        {
+            if (values[i] != (i % 2U == 0U ? 1.F : -1.F) * static_cast<float_t>(i) * 0.25F)
+            {
+                errors = true;
+                std::cerr << "Mismatch text value " << i << " = " << values[i] << std::endl;
+                break;
+            }
+        }
+        reader.close();
+
+        // A count of 2^30 + 1 bodies wraps to a single row of four values in 32 bits
+        {
+            std::ofstream file{filename};
+            file << "1073741825\n1 2 3 4\n";
+        }
+        md::World world{};
+        if (world.initialize(filename))
+        {
+            errors = true;
+            std::cerr << "Mismatch body count exceeding the file accepted" << std::endl;
+        }
+        std::remove(filename.c_str());
+    }
+
+    // Generated initial conditions
+    {
+        md::Particles particles{};
+        const float_t volume{md::generate::lattice(particles, md::generate::Lattice::Fcc, 4U, 1.F, 2.F)};
+        md::generate::maxwellBoltzmann(particles, 1.5F, 3U);
+        double kinetic{0.};
+        double momentum{0.};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            for (size_t i{0U}; i < particles.size(); ++i)
+            {
+                kinetic += .5 * particles.mass()[i] * particles.velocity(k)[i] * particles.velocity(k)[i];
+                momentum += particles.mass()[i] * particles.velocity(k)[i];
+            }
+        }
+        const double temperature{2. * kinetic / (3. * static_cast<double>(particles.size()))};
+        if (particles.size() != 256U || !ode::equal(volume, 64.F * std::sqrt(8.F), 1e-4F) || !ode::equal(temperature, 1.5, 1e-4) || std::abs(momentum) > 1e-3)
+        {
+            errors = true;
+            std::cerr << "Mismatch lattice size=" << particles.size() << " volume=" << volume << " temperature=" << temperature << std::endl;
+        }
+    }
+
+    // Random gas in a periodic cube keeps its minimum distance across the faces
+    {
+        md::Particles particles{};
+        static constexpr float_t side{12.F};
+        static constexpr float_t minimum{1.F};
+        const float_t volume{md::generate::gas(particles, 1000U, side, minimum, 1.F, 11U, true)};
+        float_t closest{std::numeric_limits<float_t>::max()};
+        for (size_t i{0U}; i < particles.size(); ++i)
+        {
+            for (size_t j{i + 1U}; j < particles.size(); ++j)
+            {
+                float_t r2{0.F};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    float_t d{particles.position(k)[i] - particles.position(k)[j]};
+                    d -= side * std::round(d / side);
+                    r2 += d * d;
+                }
+                closest = std::min(closest, std::sqrt(r2));
+            }
+        }
+        if (particles.size() != 1000U || volume != side * side * side || closest < minimum * (1.F - 1e-5F))
+        {
+            errors = true;
+            std::cerr << "Mismatch periodic gas size=" << particles.size() << " closest=" << closest << std::endl;
+        }
+    }
+
+    // Periodic domain decomposition
+    {
+        md::Particles particles{};
+        const float_t side{std::cbrt(md::generate::lattice(particles, md::generate::Lattice::Fcc, 6U, 45.F, 1.F))};
+        std::mt19937 generator{5U};
+        std::uniform_real_distribution<float_t> jitter{-5.F, 5.F};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            std::for_each(particles.position(k), particles.position(k) + particles.size(), [&](float_t& r) { r += jitter(generator); });
+        }
+
+        // Minimum image forces of all pairs
+        md::lj::Parameters parameters{};
+        const size_t count{particles.size()};
+        std::vector<double> expected(3U * count, 0.);
+        double potential{0.};
+        for (size_t i{0U}; i < count; ++i)
+        {
+            for (size_t j{i + 1U}; j < count; ++j)
+            {
+                double d[3];
+                double r2{0.};
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    d[k] = static_cast<double>(particles.position(k)[i]) - particles.position(k)[j];
+                    d[k] -= side * std::nearbyint(d[k] / side);
+                    r2 += d[k] * d[k];
+                }
+                if (r2 < parameters.cutoff2)
+                {
+                    const double rho3{std::pow(parameters.sigma2 / r2, 3.)};
+                    const double f{24. * parameters.epsilon * (2. * rho3 - 1.) * rho3 / r2};
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        expected[k * count + i] += f * d[k];
+                        expected[k * count + j] -= f * d[k];
+                    }
+                    potential += 4. * parameters.epsilon * (rho3 - 1.) * rho3;
+                }
+            }
+        }
+
+        const float_t box[3]{side, side, side};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            parameters.box[k] = side;
+        }
+        for (const size_t threads : {1U, 4U})
+        {
+            ode::ThreadPool pool{threads};
+            md::Domains domains{};
+            md::Particles copy{particles};
+            domains.setBox(box, 100.F, 10.F);
+            const md::lj::Sums sums{domains.forces(copy, parameters, md::lj::kernel(true, true), pool)};
+            double scale{0.};
+            double difference{0.};
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                for (size_t i{0U}; i < count; ++i)
+                {
+                    scale = std::max(scale, std::abs(expected[k * count + i]));
+                    difference = std::max(difference, std::abs(expected[k * count + i] - copy.force(k)[i]));
+                }
+            }
+            if (difference > 1e-4 * scale || !ode::equal(static_cast<double>(sums.potential), potential, 1e-4 * std::abs(potential)) || domains.size() != std::min<size_t>(threads, 3U))
+            {
+                errors = true;
+                std::cerr << "Mismatch periodic forces threads=" << threads << " force=" << difference << " / " << scale << " potential=" << sums.potential << " != " << potential << std::endl;
+            }
+        }
+    }
+
+    // A cutoff or box breaking the minimum image convention is rejected
+    {
+        md::World world{};
+        const float_t box[3]{1000.F, 1000.F, 1000.F};
+        const float_t small[3]{1000.F, 1000.F, 100.F};
+        const float_t cutoff{world.neighbors().cutoff()};
+        if (!world.setBox(box) || world.setBox(small) || world.setCutoff(600.F, 10.F) || world.neighbors().cutoff() != cutoff || !world.setCutoff(400.F, 10.F) || world.neighbors().cutoff() != 400.F)
+        {
+            errors = true;
+            std::cerr << "Mismatch rejected periodic box or cutoff=" << world.neighbors().cutoff() << std::endl;
+        }
+    }
+
+    // Parallel forces against serial forces
+    {
+        md::Particles particles{};
+        md::generate::lattice(particles, md::generate::Lattice::Fcc, 8U, 45.F, 1.F);
+        std::mt19937 generator{7U};
+        std::uniform_real_distribution<float_t> jitter{-5.F, 5.F};
+        for (size_t k{0U}; k < 3U; ++k)
+        {
+            std::for_each(particles.position(k), particles.position(k) + particles.size(), [&](float_t& r) { r += jitter(generator); });
+        }
+        std::vector<std::vector<float_t>> forces{};
+        for (const size_t threads : {1U, 4U, 4U})
+        {
+            md::World world{};
+            world.setThreads(threads);
+            world.initialize(md::Particles{particles});
+            world.lennardJones();
+            std::vector<float_t> force{};
+            for (size_t k{0U}; k < 3U; ++k)
+            {
+                force.insert(force.end(), world.particles().force(k), world.particles().force(k) + particles.size());
+            }
+            forces.push_back(std::move(force));
+        }
+        double scale{0.};
+        double difference{0.};
+        for (size_t i{0U}; i < forces[0].size(); ++i)
+        {
+            scale = std::max(scale, std::abs(static_cast<double>(forces[0][i])));
+            difference = std::max(difference, std::abs(static_cast<double>(forces[0][i]) - forces[1][i]));
+        }
+        // The parallel forces are summed in another order, but the same for every run
+        if (particles.size() <= 1024U || difference > 1e-5 * scale || forces[1] != forces[2])
+        {
+            errors = true;
+            std::cerr << "Mismatch parallel forces bodies=" << particles.size() << " force=" << difference << " / " << scale << std::endl;
+        }
+    }
+
+    // Symmetric direct sum of the gravity against all pairs in double precision
+    {
+        static constexpr size_t count{1500U};
+        std::mt19937 generator{13U};
+        std::uniform_real_distribution<float_t> distribution{-100.F, 100.F};
+        std::vector<float_t> positions(3U * count);
+        std::vector<float_t> masses(count);
+        for (auto& position : positions)
+        {
+            position = distribution(generator);
+        }
+        for (auto& mass : masses)
+        {
+            mass = 1.F + distribution(generator) / 200.F;
+        }
+        std::vector<double> expected(3U * count, 0.);
+        for (size_t i{0U}; i < count; ++i)
+        {
+            for (size_t j{0U}; j < count; ++j)
+            {
+                if (i != j)
+                {
+                    double d[3];
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        d[k] = static_cast<double>(positions[j * 3U + k]) - positions[i * 3U + k];
+                    }
+                    const double r2{d[0] * d[0] + d[1] * d[1] + d[2] * d[2]};
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        expected[i * 3U + k] += masses[j] * d[k] / (r2 * std::sqrt(r2));
+                    }
+                }
+            }
+        }
+        for (const bool vectorized : {false, true})
+        {
+            for (const size_t threads : {1U, 4U})
+            {
+                ode::ThreadPool pool{threads};
+                pd::DirectSum direct{};
+                direct.setVectorized(vectorized);
+                std::vector<float_t> accelerations(3U * count);
+                direct.accelerations(
+                    count, [&](size_t i, size_t k) { return positions[i * 3U + k]; }, masses.data(),
+                    [&](size_t i, const float_t* acceleration) { std::copy(acceleration, acceleration + 3, accelerations.begin() + static_cast<std::ptrdiff_t>(i * 3U)); }, pool);
+                double scale{0.};
+                double difference{0.};
+                for (size_t i{0U}; i < 3U * count; ++i)
+                {
+                    scale = std::max(scale, std::abs(expected[i]));
+                    difference = std::max(difference, std::abs(expected[i] - accelerations[i]));
+                }
+                if (difference > 1e-4 * scale)
+                {
+                    errors = true;
+                    std::cerr << "Mismatch direct sum vectorized=" << vectorized << " threads=" << threads << " acceleration=" << difference << " / " << scale << std::endl;
+                }
+
+                // Only every 7th body by the field kernel
+                std::vector<size_t> active{};
+                for (size_t i{0U}; i < count; i += 7U)
+                {
+                    active.push_back(i);
+                }
+                std::fill(accelerations.begin(), accelerations.end(), 0.F);
+                direct.accelerations(
+                    count, [&](size_t i, size_t k) { return positions[i * 3U + k]; }, masses.data(), active.data(), active.size(),
+                    [&](size_t i, const float_t* acceleration) { std::copy(acceleration, acceleration + 3, accelerations.begin() + static_cast<std::ptrdiff_t>(i * 3U)); }, pool);
+                difference = 0.;
+                for (size_t i{0U}; i < count; ++i)
+                {
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        difference = std::max(difference, std::abs((i % 7U == 0U ? expected[i * 3U + k] : 0.) - accelerations[i * 3U + k]));
+                    }
+                }
+                if (difference > 1e-4 * scale)
+                {
+                    errors = true;
+                    std::cerr << "Mismatch direct sum of listed bodies vectorized=" << vectorized << " threads=" << threads << " acceleration=" << difference << " / " << scale << std::endl;
+                }
+            }
+        }
+    }
+
+    // Barnes Hut octree against the sum of all pairs
+    {
+        static constexpr size_t count{5000U};
+        std::vector<pd::Body> bodies(count);
+        std::mt19937 generator{11U};
+        std::uniform_real_distribution<float_t> distribution{-1.F, 1.F};
+        for (auto& body : bodies)
+        {
+            do
+            {
+                body.position = pd::Vector3{distribution(generator), distribution(generator), distribution(generator)};
+            } while (body.position.length() > 1.F);
+            body.position *= 100.F;
+            body.mass = 1.F + distribution(generator) * distribution(generator);
+        }
+        std::vector<float_t> masses(count);
+        std::transform(bodies.begin(), bodies.end(), masses.begin(), [](const pd::Body& body) { return body.mass; });
+        pd::World world{};
+        world.initialize(std::move(bodies));
+        pd::Function& function{world};
+        pd::Vector y{function.getParams()};
+        pd::Vector direct(y.size());
+        function.derive(0.F, y, direct);
+
+        // Relative root mean square error of the accelerations
+        auto error = [&](const pd::Vector& dydx) {
+            double difference{0.};
+            double norm{0.};
+            for (size_t i{0U}; i < count; ++i)
+            {
+                for (size_t k{3U}; k < 6U; ++k)
+                {
+                    difference += std::pow(static_cast<double>(dydx[i * 6U + k]) - direct[i * 6U + k], 2.);
+                    norm += std::pow(static_cast<double>(direct[i * 6U + k]), 2.);
+                }
+            }
+            return std::sqrt(difference / norm);
+        };
+        pd::Vector octree[3]{pd::Vector(y.size()), pd::Vector(y.size()), pd::Vector(y.size())};
+        world.setTheta(0.25F);
+        function.derive(0.F, y, octree[0]);
+        world.setTheta(0.5F);
+        function.derive(0.F, y, octree[1]);
+        world.setThreads(4U);
+        function.derive(0.F, y, octree[2]);
+        const double errors2[2]{error(octree[0]), error(octree[1])};
+        if (errors2[1] > 1e-2 || errors2[0] > errors2[1] || !std::equal(octree[1].begin(), octree[1].end(), octree[2].begin()) || !std::equal(y.begin() + 3, y.begin() + 6, octree[1].begin()))
+        {
+            errors = true;
+            std::cerr << "Mismatch Barnes Hut error theta=0.25: " << errors2[0] << " theta=0.5: " << errors2[1] << std::endl;
+        }
+        if (!silent)
+        {
+            std::cout << "Barnes Hut error theta=0.25: " << errors2[0] << " theta=0.5: " << errors2[1] << std::endl;
+        }
+
+        // The listed bodies take the same paths through the tree
+        pd::Octree tree{};
+        ode::ThreadPool pool{4U};
+        std::vector<size_t> active{};
+        for (size_t i{0U}; i < count; i += 5U)
+        {
+            active.push_back(i);
+        }
+        pd::Vector listed(y.size());
+        tree.build(count, [&y](size_t i, size_t k) { return y[i * 6U + k]; }, masses.data(), pool);
+        tree.accelerations(active.data(), active.size(), [&listed](size_t i, const float_t* acceleration) { std::copy(acceleration, acceleration + 3, &listed[i * 6U + 3U]); }, pool);
+        for (const size_t i : active)
+        {
+            if (!std::equal(&listed[i * 6U + 3U], &listed[i * 6U + 6U], &octree[1][i * 6U + 3U]))
+            {
+                errors = true;
+                std::cerr << "Mismatch Barnes Hut acceleration of listed body " << i << std::endl;
+                break;
+            }
+        }
+    }
+
+    // Symplectic integration of planetary orbits with large steps
+    {
+        // Sun and two planets on circular orbits, the period of the inner one is 2 * pi * 100 / 10
+        auto system = [](const float_t planet) {
+            std::vector<pd::Body> bodies(3U);
+            bodies[0].mass = 1e4F;
+            bodies[1].position[0] = 100.F;
+            bodies[1].velocity[1] = 10.F;
+            bodies[1].mass = planet;
+            bodies[2].position[1] = 160.F;
+            bodies[2].velocity[0] = -std::sqrt(1e4F / 160.F);
+            bodies[2].mass = planet;
+            return bodies;
+        };
+        auto energy = [](const pd::PlanetaryFunction& function) {
+            pd::Vector q{};
+            pd::Vector v{};
+            pd::Vector mu{};
+            function.getState(q, v);
+            function.getMasses(mu);
+            double sum{0.};
+            for (size_t i{0U}; i < mu.size(); ++i)
+            {
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    sum += .5 * mu[i] * v[i * 3U + k] * v[i * 3U + k];
+                }
+                for (size_t j{i + 1U}; j < mu.size(); ++j)
+                {
+                    double r2{0.};
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        r2 += std::pow(static_cast<double>(q[i * 3U + k]) - q[j * 3U + k], 2.);
+                    }
+                    sum -= static_cast<double>(mu[i]) * mu[j] / std::sqrt(r2);
+                }
+            }
+            return sum;
+        };
+        static constexpr float_t period{62.831853F};
+        const pd::World::Integrator integrators[4]{pd::World::Integrator::RungeKutta, pd::World::Integrator::Leapfrog, pd::World::Integrator::Yoshida4, pd::World::Integrator::WisdomHolman};
+        double drift[4]{};
+        for (size_t n{0U}; n < 4U; ++n)
+        {
+            pd::World world{};
+            world.initialize(system(1.F));
+            world.setIntegrator(integrators[n]);
+            const double initial{energy(world)};
+            const float_t step{period / 20.F};
+            for (size_t k{0U}; k < 400U; ++k)
+            {
+                world.step(static_cast<float_t>(k) * step, step);
+            }
+            drift[n] = std::abs(energy(world) / initial - 1.);
+        }
+        if (drift[1] > 1e-2 || drift[2] > drift[1] || drift[3] > 1e-4 || drift[3] > drift[0])
+        {
+            errors = true;
+            std::cerr << "Mismatch energy error RungeKutta=" << drift[0] << " Leapfrog=" << drift[1] << " Yoshida4=" << drift[2] << " WisdomHolman=" << drift[3] << std::endl;
+        }
+        if (!silent)
+        {
+            std::cout << "Energy error RungeKutta=" << drift[0] << " Leapfrog=" << drift[1] << " Yoshida4=" << drift[2] << " WisdomHolman=" << drift[3] << std::endl;
+        }
+
+        // Without interactions the Wisdom Holman mapping follows the Kepler orbits exactly
+        pd::World world{};
+        world.initialize(system(0.F));
+        world.setIntegrator(pd::World::Integrator::WisdomHolman);
+        for (size_t k{0U}; k < 160U; ++k)
+        {
+            world.step(static_cast<float_t>(k) * period / 16.F, period / 16.F);
+        }
+        pd::Vector q{};
+        pd::Vector v{};
+        static_cast<const pd::PlanetaryFunction&>(world).getState(q, v);
+        if (!ode::equal(q[3u], 100.F, 1e-2F) || !ode::equal(q[4u], 0.F, 1e-2F) || !ode::equal(v[4u], 10.F, 1e-3F))
+        {
+            errors = true;
+            std::cerr << "Mismatch Kepler orbit after 10 periods x=" << q[3u] << " y=" << q[4u] << std::endl;
+        }
+    }
+
+    // Block time steps of a wide hierarchy
+    {
+        // Two planets with periods of about 2 and 40 light bodies with periods above 1000 around a sun
+        std::vector<pd::Body> bodies(43U);
+        bodies[0].mass = 1e4F;
+        for (size_t n{1U}; n < bodies.size(); ++n)
+        {
+            const float_t radius{n < 3U ? 6.F + 4.F * static_cast<float_t>(n) : 300.F + 17.F * static_cast<float_t>(n)};
+            const float_t angle{.7F * static_cast<float_t>(n)};
+            const float_t speed{std::sqrt(1e4F / radius)};
+            bodies[n].position = pd::Vector3{radius * std::cos(angle), radius * std::sin(angle), 0.F};
+            bodies[n].velocity = pd::Vector3{-speed * std::sin(angle), speed * std::cos(angle), 0.F};
+            bodies[n].mass = n < 3U ? 1.F : 1e-2F;
+        }
+        auto energy = [](const pd::PlanetaryFunction& function) {
+            pd::Vector q{};
+            pd::Vector v{};
+            pd::Vector mu{};
+            function.getState(q, v);
+            function.getMasses(mu);
+            double sum{0.};
+            for (size_t i{0U}; i < mu.size(); ++i)
+            {
+                for (size_t k{0U}; k < 3U; ++k)
+                {
+                    sum += .5 * mu[i] * v[i * 3U + k] * v[i * 3U + k];
+                }
+                for (size_t j{i + 1U}; j < mu.size(); ++j)
+                {
+                    double r2{0.};
+                    for (size_t k{0U}; k < 3U; ++k)
+                    {
+                        r2 += std::pow(static_cast<double>(q[i * 3U + k]) - q[j * 3U + k], 2.);
+                    }
+                    sum -= static_cast<double>(mu[i]) * mu[j] / std::sqrt(r2);
+                }
+            }
+            return sum;
+        };
+
+        // Block steps of 10 against a global leapfrog step of about the finest block step
+        static constexpr float_t duration{40.F};
+        double drift[2]{};
+        size_t evaluations[2]{};
+        for (size_t n{0U}; n < 2U; ++n)
+        {
+            pd::World world{};
+            world.initialize(std::vector<pd::Body>{bodies});
+            world.setIntegrator(n == 0U ? pd::World::Integrator::BlockTimesteps : pd::World::Integrator::Leapfrog);
+            world.setBlockTimesteps(.02F, 16U);
+            const double initial{energy(world)};
+            const float_t step{n == 0U ? 10.F : .005F};
+            for (size_t k{0U}; static_cast<float_t>(k) * step < duration; ++k)
+            {
+                world.step(static_cast<float_t>(k) * step, step);
+            }
+            drift[n] = std::abs(energy(world) / initial - 1.);
+            evaluations[n] = world.evaluations();
+        }
+        if (evaluations[0] * 10U > evaluations[1] || drift[0] > 1e-5)
+        {
+            errors = true;
+            std::cerr << "Mismatch block time steps evaluations=" << evaluations[0] << " / " << evaluations[1] << " energy error=" << drift[0] << " / " << drift[1] << std::endl;
+        }
+        if (!silent)
+        {
+            std::cout << "Block time steps evaluations=" << evaluations[0] << " / " << evaluations[1] << " energy error=" << drift[0] << " / " << drift[1] << std::endl;
+        }
+    }
+
+    // A planet checkpoint with more bodies than it holds is invalid
+    {
+        const std::string filename{"Bodies.chk"};
+        ode::Archive archive{};
+        archive.begin(0x5044U);
+        archive.write(std::numeric_limits<uint64_t>::max() / 2U);
+        archive.write(std::string{"Earth"});
+        archive.save(filename);
+        pd::World world{};
+        if (world.restore(filename))
+        {
+            errors = true;
+            std::cerr << "Mismatch planet checkpoint with too many bodies restored" << std::endl;
+        }
+        std::remove(filename.c_str());
+    }
+
+    // Block levels of a checkpoint are clamped to fewer levels of the restarted run
+    {
+        const std::string filename{"Blocks.chk"};
+        ode::Archive archive{};
+        archive.begin(0U);
+        archive.write(uint64_t{16U});
+        archive.write(uint64_t{2U});
+        archive.write(std::vector<uint64_t>{12U, 1U});
+        const float_t accelerations[6]{};
+        archive.write(accelerations, 6U);
+        archive.save(filename);
+        pd::BlockTimesteps blocks{};
+        blocks.setLevels(4U);
+        if (!archive.load(filename, 0U) || !blocks.read(archive) || blocks.level(0U) != 4U || blocks.level(1U) != 1U)
+        {
+            errors = true;
+            std::cerr << "Mismatch restored block levels" << std::endl;
+        }
+        std::remove(filename.c_str());
+    }
+
+    // Sampled output of a range of bodies split into a file per body
+    {
+        std::vector<pd::Body> bodies(4U);
+        for (size_t i{0U}; i < bodies.size(); ++i)
+        {
+            bodies[i].name = "Split" + std::to_string(i);
+            bodies[i].position[0] = 100.F * static_cast<float_t>(i);
+            bodies[i].velocity[1] = i > 0U ? std::sqrt(1e4F / bodies[i].position[0]) : 0.F;
+            bodies[i].mass = i > 0U ? 1.F : 1e4F;
+        }
+        static constexpr float_t step{0.1F};
+        pd::World world{};
+        world.setBinaryOutput(true, step);
+        world.setOutput(3U, 1U, 2U, true);
+        world.initialize(std::move(bodies));
+        std::vector<float_t> expected{};
+        if (!world.openOutput())
+        {
+            errors = true;
+        }
+        for (size_t k{0U}; k < 9U; ++k)
+        {
+            world.step(static_cast<float_t>(k) * step, step);
+            if (k % 3U == 0U)
+            {
+                pd::Vector q{};
+                pd::Vector v{};
+                static_cast<const pd::PlanetaryFunction&>(world).getState(q, v);
+                expected.insert(expected.end(), &q[3U], &q[3U] + 6U);
+            }
+        }
+        world.finish();
+
+        // Every 3rd step of the bodies 1 and 2
+        ode::TrajectoryReader<float_t> reader{};
+        bool equal{reader.open("Solarsystem.trj") && reader.frames() == 3U && reader.particles() == 2U && reader.timeStep() == static_cast<double>(3.F * step)};
+        for (size_t f{0U}; equal && f < reader.frames(); ++f)
+        {
+            equal = std::equal(reader.frame(f), reader.frame(f) + 6U, expected.begin() + static_cast<std::ptrdiff_t>(f * 6U));
+        }
+        std::ifstream file{"Split1.dat"};
+        std::string line{};
+        size_t rows{0U};
+        while (std::getline(file, line))
+        {
+            ++rows;
+        }
+        file.close();
+        if (!equal || rows != 3U || std::ifstream{"Split2.dat"}.fail() || !std::ifstream{"Split0.dat"}.fail() || !std::ifstream{"Split3.dat"}.fail())
+        {
+            errors = true;
+            std::cerr << "Mismatch sampled output of bodies 1 and 2 frames=" << reader.frames() << " rows=" << rows << std::endl;
+        }
+        reader.close();
+        std::remove("Split1.dat");
+        std::remove("Split2.dat");
+        std::remove("Solarsystem.trj");
+    }
+
+    // Runge Kutta steps of the planet dynamics reuse their workspace
+    {
+        std::vector<pd::Body> bodies(3U);
+        for (size_t i{0U}; i < bodies.size(); ++i)
+        {
+            bodies[i].position[0] = 100.F * static_cast<float_t>(i);
+            bodies[i].velocity[1] = i > 0U ? std::sqrt(1e4F / bodies[i].position[0]) : 0.F;
+            bodies[i].mass = i > 0U ? 1.F : 1e4F;
+        }
+        pd::World world{};
+        world.setThreads(1U);
+        world.initialize(std::move(bodies));
+        world.step(0.F, .1F);
+        const size_t before{allocations};
+        for (size_t k{1U}; k < 10U; ++k)
+        {
+            world.step(static_cast<float_t>(k) * .1F, .1F);
+        }
+        if (allocations != before)
+        {
+            errors = true;
+            std::cerr << "Heap allocations in planet dynamics steps = " << (allocations - before) << std::endl;
+        }
+    }
+
+    // Steps with a reused workspace must not allocate, velocity verlet integrates second order equations and is only checked for allocations
+    VelocityVerlet vv{};
+    Solver* solvers[] = {&euler, &mp, &rk, &vv};
+    for (auto* solver : solvers)
+    {
+        Derivative y4{};
+        Workspace workspace{};
+        solver->calc(0.F, dt, y4, workspace);
+        const size_t before{allocations};
+        for (float_t t{dt}; t < 1.F; t += dt)
+        {
+            solver->calc(t, dt, y4, workspace);
+        }
+        if (allocations != before)
+        {
+            errors = true;
+            std::cerr << "Heap allocations in workspace step = " << (allocations - before) << std::endl;
+        }
+        if (solver != &vv && !ode::equal(y4.getParams()[0u], sinf(1.F), e))
+        {
+            errors = true;
+            std::cerr << "Mismatch workspace step(1)=" << y4.getParams()[0u] << " != " << sinf(1.F) << std::endl;
+        }
+    }
+
     return (errors ? -1 : 0);
 }
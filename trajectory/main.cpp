@@ -0,0 +1,84 @@
+#include "ode/FrameWriter.h"
+#include "ode/Trajectory.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+/**
+ * main function
+ */
+int main(int argc, char** argv)
+{
+    std::string input{};
+    std::string output{};
+    size_t first{0U};
+    size_t count{0U};
+    bool split{false};
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--particles" && i + 2 < argc)
+        {
+            first = std::stoul(argv[++i]);
+            count = std::stoul(argv[++i]);
+        }
+        else if (argument == "--split")
+        {
+            split = true;
+        }
+        else if (input.empty())
+        {
+            input = argument;
+        }
+        else
+        {
+            output = argument;
+        }
+    }
+    if (input.empty())
+    {
+        std::cout << "Usage: trj input.trj [output.dat] [--particles first count] [--split]" << std::endl;
+        return 1;
+    }
+    if (output.empty())
+    {
+        output = input.substr(0U, input.rfind('.')) + ".dat";
+    }
+
+    ode::TrajectoryReader<float_t> reader{};
+    if (!reader.open(input))
+    {
+        std::cout << "Invalid file " << input << std::endl;
+        return 1;
+    }
+    const size_t particles{reader.particles()};
+    const size_t dimension{reader.dimension()};
+    first = std::min(first, particles);
+    count = count == 0U ? particles - first : std::min(count, particles - first);
+    std::cout << "Particles = " << particles << ", frames = " << reader.frames() << ", time step = " << reader.timeStep() << std::endl;
+
+    // One file per particle, output.0.dat, output.1.dat, ...
+    if (split)
+    {
+        const std::string stem{output.substr(0U, output.rfind('.'))};
+        const size_t files{ode::split(reader, first, count, [&stem](size_t i) { return stem + "." + std::to_string(i) + ".dat"; })};
+        std::cout << "Files = " << files << std::endl;
+        return files == count ? 0 : 1;
+    }
+
+    // Same text layout as the simulations, one row of all selected particles per frame
+    ode::FrameWriter<float_t> writer{};
+    if (!writer.open(output, first * dimension, count * dimension))
+    {
+        std::cout << "Can't write " << output << std::endl;
+        return 1;
+    }
+    for (size_t k{0U}; k < reader.frames(); ++k)
+    {
+        const float_t* frame{reader.frame(k)};
+        writer.push(reader.variable(k), particles * dimension, [&](float_t* values) { std::copy(frame, frame + particles * dimension, values); });
+    }
+    writer.close();
+    return 0;
+}